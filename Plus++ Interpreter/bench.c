@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "bench.h"
+#include "bigint.h"
+#include "ntt.h"
+#include "output.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// The time stamp counter gives cycles per operation on x86 (reference cycles, at the nominal clock rate)
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BENCH_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+void mag_mul(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn);
+void mag_mul_schoolbook(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn);
+
+// Algorithms compared by the benchmark
+#define BENCH_SCHOOLBOOK 0
+#define BENCH_KARATSUBA 1
+#define BENCH_NTT 2
+
+// Largest operand size timed for each algorithm; schoolbook is quadratic, so it stops early
+int bench_max_limbs[3] = {1 << 14, 1 << 18, 1 << 20};
+const char *bench_names[3] = {"schoolbook", "karatsuba", "ntt"};
+
+// Returns a monotonic time in seconds
+double bench_seconds()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// Function to multiply with one algorithm only. Karatsuba keeps its schoolbook base case but never hands over to NTT.
+void bench_multiply(int algorithm, uint32_t *r, const uint32_t *a, const uint32_t *b, int n)
+{
+    if (algorithm == BENCH_SCHOOLBOOK)
+    {
+        mag_mul_schoolbook(r, a, n, b, n);
+    }
+    else if (algorithm == BENCH_KARATSUBA)
+    {
+        ntt_cutoff = INT_MAX;
+        mag_mul(r, a, n, b, n);
+        ntt_cutoff = NTT_CUTOFF;
+    }
+    else
+    {
+        mag_mul_ntt(r, a, n, b, n);
+    }
+}
+
+// Function to time one algorithm on n-limb operands: repeats the product until 0.2 seconds have passed and
+// returns the average time of one product in seconds
+double bench_time(int algorithm, uint32_t *r, const uint32_t *a, const uint32_t *b, int n)
+{
+    int runs = 0;
+    double start = bench_seconds(), elapsed;
+    do
+    {
+        bench_multiply(algorithm, r, a, b, n);
+        runs++;
+        elapsed = bench_seconds() - start;
+    } while (elapsed < 0.2);
+    return elapsed / runs;
+}
+
+// Prints a time with a readable unit
+void print_duration(double seconds)
+{
+    if (seconds < 0)
+        printf("%14s", "-");
+    else if (seconds < 1e-3)
+        printf("%11.2f us", seconds * 1e6);
+    else if (seconds < 1)
+        printf("%11.2f ms", seconds * 1e3);
+    else
+        printf("%12.2f s", seconds);
+}
+
+// Function to run the multiplication benchmark
+void benchmark_multiplication()
+{
+    int max_limbs = bench_max_limbs[BENCH_NTT];
+    uint32_t *a = malloc(max_limbs * sizeof(uint32_t));
+    uint32_t *b = malloc(max_limbs * sizeof(uint32_t));
+    uint32_t *r = malloc(2 * max_limbs * sizeof(uint32_t));
+    uint32_t *check = malloc(2 * max_limbs * sizeof(uint32_t));
+
+    // Fixed pseudo-random operands (xorshift), so runs are comparable
+    uint32_t state = 2463534242u;
+    for (int i = 0; i < max_limbs; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        a[i] = state;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        b[i] = state;
+    }
+
+    int takeover[3] = {0, 0, 0};
+
+    printf("Multiplication of two n-limb numbers (32-bit limbs, about 9.63 digits each):\n");
+    printf("%10s %12s %14s %14s %14s  %s\n", "limbs", "digits", "schoolbook", "karatsuba", "ntt", "fastest");
+    for (int n = 16; n <= max_limbs; n *= 2)
+    {
+        double times[3];
+        int fastest = -1, checked = 0;
+        for (int algorithm = 0; algorithm < 3; algorithm++)
+        {
+            times[algorithm] = -1;
+            if (n > bench_max_limbs[algorithm])
+                continue;
+            times[algorithm] = bench_time(algorithm, r, a, b, n);
+            if (fastest < 0 || times[algorithm] < times[fastest])
+                fastest = algorithm;
+
+            // Every algorithm has to produce exactly the same limbs
+            if (checked && memcmp(r, check, 2 * n * sizeof(uint32_t)) != 0)
+            {
+                fprintf(stderr, "[ERROR]: %s multiplication disagrees at %d limbs.\n", bench_names[algorithm], n);
+                exit(1);
+            }
+            memcpy(check, r, 2 * n * sizeof(uint32_t));
+            checked = 1;
+        }
+
+        printf("%10d %12.0f ", n, n * 9.633);
+        for (int algorithm = 0; algorithm < 3; algorithm++)
+        {
+            print_duration(times[algorithm]);
+            printf(" ");
+        }
+        printf(" %s\n", bench_names[fastest]);
+        fflush(stdout);
+
+        // Each algorithm takes over from the one before it at the smallest size from which it stays faster
+        for (int algorithm = 1; algorithm < 3; algorithm++)
+        {
+            if (times[algorithm] < 0 || times[algorithm - 1] < 0)
+                continue;
+            if (times[algorithm] >= times[algorithm - 1])
+                takeover[algorithm] = 0;
+            else if (!takeover[algorithm])
+                takeover[algorithm] = n;
+        }
+    }
+
+    printf("\n");
+    for (int algorithm = 1; algorithm < 3; algorithm++)
+    {
+        int cutoff = algorithm == BENCH_KARATSUBA ? KARATSUBA_CUTOFF : NTT_CUTOFF;
+        if (takeover[algorithm])
+            printf("%s takes over from %s at about %d limbs", bench_names[algorithm], bench_names[algorithm - 1], takeover[algorithm]);
+        else
+            printf("%s never overtakes %s", bench_names[algorithm], bench_names[algorithm - 1]);
+        printf(" (compiled-in cutoff: %d limbs).\n", cutoff);
+    }
+
+    free(a);
+    free(b);
+    free(r);
+    free(check);
+}
+
+// Warm-up time before a kernel is measured, and the number and minimum length of the samples taken
+#define MICRO_WARMUP_SECONDS 0.05
+#define MICRO_SAMPLES 15
+#define MICRO_SAMPLE_SECONDS 0.01
+
+// Runs an operation the given number of times
+typedef void (*MicroKernel)(void *context, long long iterations);
+
+// Median time and cycles of one operation over the samples, and the median absolute deviation of the time
+// relative to its median (the spread between samples)
+typedef struct
+{
+    double ns_per_op;
+    double cycles_per_op;
+    double spread;
+} MicroResult;
+
+// Returns the time stamp counter, 0 where there is none
+unsigned long long bench_cycles()
+{
+#ifdef BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Orders doubles from smallest to largest
+int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Returns the median of n values, sorting them
+double median(double *values, int n)
+{
+    qsort(values, n, sizeof(double), compare_doubles);
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// Function to measure a kernel: warms it up, finds an iteration count that makes a sample last at least
+// MICRO_SAMPLE_SECONDS and takes the median of MICRO_SAMPLES samples, which ignores the ones disturbed by the rest of
+// the machine
+void micro_measure(MicroKernel kernel, void *context, MicroResult *result)
+{
+    long long iterations = 1;
+    double start = bench_seconds(), elapsed;
+    while (1)
+    {
+        double sample_start = bench_seconds();
+        kernel(context, iterations);
+        elapsed = bench_seconds() - sample_start;
+        if (elapsed >= MICRO_SAMPLE_SECONDS && bench_seconds() - start >= MICRO_WARMUP_SECONDS)
+            break;
+        if (elapsed < MICRO_SAMPLE_SECONDS)
+            iterations *= 2;
+    }
+
+    double ns[MICRO_SAMPLES], cycles[MICRO_SAMPLES], deviations[MICRO_SAMPLES];
+    for (int i = 0; i < MICRO_SAMPLES; i++)
+    {
+        double sample_start = bench_seconds();
+        unsigned long long cycle_start = bench_cycles();
+        kernel(context, iterations);
+        cycles[i] = (double)(bench_cycles() - cycle_start) / iterations;
+        ns[i] = (bench_seconds() - sample_start) * 1e9 / iterations;
+    }
+
+    result->ns_per_op = median(ns, MICRO_SAMPLES);
+    result->cycles_per_op = median(cycles, MICRO_SAMPLES);
+    for (int i = 0; i < MICRO_SAMPLES; i++)
+        deviations[i] = ns[i] > result->ns_per_op ? ns[i] - result->ns_per_op : result->ns_per_op - ns[i];
+    result->spread = median(deviations, MICRO_SAMPLES) / result->ns_per_op;
+}
+
+// Function to measure a kernel and print one line of the report
+void micro_report(const char *name, const char *size, MicroKernel kernel, void *context)
+{
+    MicroResult result;
+    micro_measure(kernel, context, &result);
+    printf("%-20s %12s %14.2f", name, size, result.ns_per_op);
+#ifdef BENCH_TSC
+    printf(" %14.1f", result.cycles_per_op);
+#else
+    printf(" %14s", "-");
+#endif
+    printf(" %8.1f%%\n", result.spread * 100);
+    fflush(stdout);
+}
+
+// Decimal parsing of a constant, as get_value() does for every use of one
+typedef struct
+{
+    char text[256];
+    BigInt value;
+} ParseContext;
+
+void micro_parse(void *context, long long iterations)
+{
+    ParseContext *c = context;
+    for (long long i = 0; i < iterations; i++)
+        bigint_parse(&c->value, c->text);
+}
+
+// One pass of the add or subtract kernel over n limbs
+typedef struct
+{
+    uint32_t *r, *a, *b;
+    int n;
+    int subtract;
+} LimbContext;
+
+void micro_limbs(void *context, long long iterations)
+{
+    LimbContext *c = context;
+    for (long long i = 0; i < iterations; i++)
+    {
+        if (c->subtract)
+            limbs_sub(c->r, c->a, c->b, c->n, 0);
+        else
+            limbs_add(c->r, c->a, c->b, c->n, 0);
+    }
+}
+
+// Conversion of a number to decimal
+typedef struct
+{
+    BigInt value;
+    char *text;
+} DecimalContext;
+
+void micro_decimal(void *context, long long iterations)
+{
+    DecimalContext *c = context;
+    for (long long i = 0; i < iterations; i++)
+        bigint_to_decimal(&c->value, c->text);
+}
+
+// Appending to the output buffer, including its share of the flushes to the output stream
+typedef struct
+{
+    const char *data;
+    size_t size;
+    long long number; // Written with output_number() if data is NULL
+} OutputContext;
+
+void micro_output(void *context, long long iterations)
+{
+    OutputContext *c = context;
+    for (long long i = 0; i < iterations; i++)
+    {
+        if (c->data)
+            output_write(c->data, c->size);
+        else
+            output_number(c->number);
+    }
+}
+
+// Function to run the kernel microbenchmarks
+void benchmark_kernels()
+{
+    char size[32];
+
+    printf("%-20s %12s %14s %14s %9s\n", "kernel", "size", "ns/op", "cycles/op", "spread");
+
+    // Decimal parsing of constants from 1 to 200 digits
+    int digits[] = {1, 10, 20, 50, 100, 200};
+    for (int i = 0; i < (int)(sizeof(digits) / sizeof(digits[0])); i++)
+    {
+        ParseContext c = {{0}, {0}};
+        for (int d = 0; d < digits[i]; d++)
+            c.text[d] = "9876543210"[d % 10];
+        snprintf(size, sizeof(size), "%d digit%s", digits[i], digits[i] == 1 ? "" : "s");
+        micro_report("parse decimal", size, micro_parse, &c);
+        bigint_free(&c.value);
+    }
+
+    // Add and subtract kernels at various widths; the first call picks the kernels for this processor
+    int max_limbs = 1 << 16;
+    uint32_t *a = malloc(max_limbs * sizeof(uint32_t));
+    uint32_t *b = malloc(max_limbs * sizeof(uint32_t));
+    uint32_t *r = malloc(max_limbs * sizeof(uint32_t));
+    uint32_t state = 2463534242u;
+    for (int i = 0; i < max_limbs; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        a[i] = state;
+        b[i] = state * 2654435761u;
+    }
+    limbs_add(r, a, b, 1, 0);
+    for (int subtract = 0; subtract < 2; subtract++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%s (%s)", subtract ? "subtract" : "add", limb_kernel_name);
+        for (int n = 1; n <= max_limbs; n *= 4)
+        {
+            LimbContext c = {r, a, b, n, subtract};
+            snprintf(size, sizeof(size), "%d limb%s", n, n == 1 ? "" : "s");
+            micro_report(name, size, micro_limbs, &c);
+        }
+    }
+    free(a);
+    free(b);
+    free(r);
+
+    // Conversion to decimal, from numbers that fit in a long long to ones with ten thousand digits
+    int lengths[] = {1, 18, 100, 1000, 10000};
+    for (int i = 0; i < (int)(sizeof(lengths) / sizeof(lengths[0])); i++)
+    {
+        char *text = malloc(lengths[i] + 1);
+        for (int d = 0; d < lengths[i]; d++)
+            text[d] = "1234567890"[d % 10];
+        text[lengths[i]] = '\0';
+
+        DecimalContext c = {{0}, NULL};
+        bigint_parse(&c.value, text);
+        c.text = malloc(bigint_decimal_size(&c.value));
+        snprintf(size, sizeof(size), "%d digit%s", lengths[i], lengths[i] == 1 ? "" : "s");
+        micro_report("to decimal", size, micro_decimal, &c);
+        bigint_free(&c.value);
+        free(c.text);
+        free(text);
+    }
+
+    // Output buffering, with the flushes going to the null device so no terminal or disk is involved
+#ifdef _WIN32
+    FILE *sink = fopen("NUL", "wb");
+#else
+    FILE *sink = fopen("/dev/null", "wb");
+#endif
+    if (sink)
+    {
+        static char block[OUTPUT_BUFFER_SIZE];
+        memset(block, 'x', sizeof(block));
+        output_set_stream(sink);
+
+        size_t writes[] = {1, 16, 256};
+        for (int i = 0; i < (int)(sizeof(writes) / sizeof(writes[0])); i++)
+        {
+            OutputContext c = {block, writes[i], 0};
+            snprintf(size, sizeof(size), "%d byte%s", (int)writes[i], writes[i] == 1 ? "" : "s");
+            micro_report("output write", size, micro_output, &c);
+        }
+
+        OutputContext number = {NULL, 0, 1234567};
+        micro_report("output number", "7 digits", micro_output, &number);
+
+        // Writing exactly one buffer per operation flushes the buffer every time
+        OutputContext flush = {block, sizeof(block), 0};
+        snprintf(size, sizeof(size), "%d KB", OUTPUT_BUFFER_SIZE / 1024);
+        micro_report("output flush", size, micro_output, &flush);
+
+        output_set_stream(NULL);
+        fclose(sink);
+    }
+    output_bytes = 0;
+
+#ifdef BENCH_TSC
+    printf("\nCycles are time stamp counter ticks, which run at the nominal clock rate of the processor.\n");
+#endif
+}
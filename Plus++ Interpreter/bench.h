@@ -0,0 +1,19 @@
+// bench.h
+#ifndef BENCH_H
+#define BENCH_H
+
+// Returns a monotonic time in seconds
+double bench_seconds();
+
+// Returns the median of n values, sorting them
+double median(double *values, int n);
+
+// Times schoolbook, Karatsuba and NTT multiplication over a range of operand sizes and prints where each
+// algorithm becomes the fastest on this machine, next to the compiled-in cutoffs
+void benchmark_multiplication();
+
+// Times the hot primitives on their own (decimal parsing, limb addition and subtraction, conversion to decimal and
+// output buffering) and prints the median ns and cycles per operation with the spread between samples
+void benchmark_kernels();
+
+#endif
@@ -0,0 +1,1299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "bigint.h"
+#include "ntt.h"
+#include "memory.h"
+
+// Vectorized limb kernels need GCC or Clang on x86 (they are compiled for AVX2 on their own and only used if
+// the processor has it); 64-bit x86 also gets add-with-carry kernels
+#if defined(__x86_64__) || defined(_M_X64)
+#define BIGINT_X86_64
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BIGINT_AVX2
+#endif
+#if defined(BIGINT_X86_64) || defined(BIGINT_AVX2)
+#include <immintrin.h>
+#endif
+
+// Eight decimal digits can be loaded as one 64-bit word with the first digit in its lowest byte
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86)
+#define BIGINT_LITTLE_ENDIAN
+#endif
+
+// Cutoffs in use (the multiplication benchmark changes them to time each algorithm on its own)
+int karatsuba_cutoff = KARATSUBA_CUTOFF;
+int ntt_cutoff = NTT_CUTOFF;
+
+// Function to make room for at least n limbs, keeping the current value
+void bigint_reserve(BigInt *a, int n)
+{
+    if (n <= a->capacity)
+        return;
+
+    int capacity = a->capacity ? a->capacity : 4;
+    while (capacity < n)
+        capacity *= 2;
+    a->limbs = memory_realloc(a->limbs, a->capacity * sizeof(uint32_t), capacity * sizeof(uint32_t));
+    a->capacity = capacity;
+}
+
+// Function to drop leading zero limbs, so the length is exact and zero is never negative
+void bigint_trim(BigInt *a)
+{
+    while (a->length > 0 && a->limbs[a->length - 1] == 0)
+        a->length--;
+    if (a->length == 0)
+        a->negative = 0;
+}
+
+// Function to free the limbs of a number
+void bigint_free(BigInt *a)
+{
+    memory_free(a->limbs, a->capacity * sizeof(uint32_t));
+    a->limbs = NULL;
+    a->negative = 0;
+    a->length = 0;
+    a->capacity = 0;
+}
+
+// Function to set a number from a machine integer
+void bigint_set_ll(BigInt *a, long long value)
+{
+    unsigned long long magnitude = value < 0 ? 0 - (unsigned long long)value : (unsigned long long)value;
+
+    if (a->capacity < 2)
+        bigint_reserve(a, 2);
+    a->negative = value < 0;
+    a->limbs[0] = (uint32_t)magnitude;
+    a->limbs[1] = (uint32_t)(magnitude >> 32);
+    a->length = magnitude > 0xFFFFFFFFu ? 2 : magnitude != 0;
+}
+
+// Function to copy a number
+void bigint_copy(BigInt *dst, const BigInt *src)
+{
+    if (dst == src)
+        return;
+
+    bigint_reserve(dst, src->length);
+    if (src->length > 0)
+        memcpy(dst->limbs, src->limbs, src->length * sizeof(uint32_t));
+    dst->length = src->length;
+    dst->negative = src->negative;
+}
+
+// Function to compute a = a * m + add over n limbs. Returns the carry out of the top limb.
+uint32_t mag_mul_small(uint32_t *a, int n, uint32_t m, uint32_t add)
+{
+    uint64_t carry = add;
+    for (int i = 0; i < n; i++)
+    {
+        carry += (uint64_t)a[i] * m;
+        a[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    return (uint32_t)carry;
+}
+
+// Function to compute a = a * m + add over n limbs with a multiplier and addend of up to 64 bits (such as 10^19).
+// Each limb is multiplied by the two halves of m, so no 128-bit arithmetic is needed. The carry stays below
+// m + 2^32, so m must be below 2^64 - 2^32. Returns the carry out of the top limb.
+uint64_t mag_mul_small64(uint32_t *a, int n, uint64_t m, uint64_t add)
+{
+    uint64_t m_low = (uint32_t)m, m_high = m >> 32;
+    uint64_t carry = add;
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t limb = a[i];
+        uint64_t low = limb * m_low + (uint32_t)carry;
+        a[i] = (uint32_t)low;
+        carry = (low >> 32) + limb * m_high + (carry >> 32);
+    }
+    return carry;
+}
+
+// Function to divide n limbs by a single limb in place. Returns the remainder.
+uint32_t mag_div_small(uint32_t *a, int n, uint32_t d)
+{
+    uint64_t rem = 0;
+    for (int i = n - 1; i >= 0; i--)
+    {
+        uint64_t cur = (rem << 32) | a[i];
+        a[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+    return (uint32_t)rem;
+}
+
+// Function to compute r = a + b + carry over n limbs, one limb at a time. Returns the carry out.
+// r may be the same array as a or b (but must not be shifted against them); the same holds for all the kernels below.
+uint32_t limbs_add_portable(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry)
+{
+    uint64_t sum = carry;
+    for (int i = 0; i < n; i++)
+    {
+        sum += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)sum;
+        sum >>= 32;
+    }
+    return (uint32_t)sum;
+}
+
+// Function to compute r = a - b - borrow over n limbs, one limb at a time. Returns the borrow out.
+uint32_t limbs_sub_portable(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t borrow)
+{
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t d = (uint64_t)a[i] - b[i] - borrow;
+        r[i] = (uint32_t)d;
+        borrow = (uint32_t)(d >> 32) & 1;
+    }
+    return borrow;
+}
+
+#ifdef BIGINT_X86_64
+// Function to add two limbs at a time with the processor's add-with-carry instruction, so the carry chain
+// is one adc per 64 bits instead of an add, shift and mask per 32 bits
+uint32_t limbs_add_adc64(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry)
+{
+    unsigned char c = (unsigned char)carry;
+    int i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        unsigned long long x, y, sum;
+        memcpy(&x, a + i, 8); // Limbs are little endian, so two of them read as one 64-bit word
+        memcpy(&y, b + i, 8);
+        c = _addcarry_u64(c, x, y, &sum);
+        memcpy(r + i, &sum, 8);
+    }
+    return limbs_add_portable(r + i, a + i, b + i, n - i, c);
+}
+
+// Function to subtract two limbs at a time with the processor's subtract-with-borrow instruction
+uint32_t limbs_sub_adc64(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t borrow)
+{
+    unsigned char c = (unsigned char)borrow;
+    int i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        unsigned long long x, y, difference;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        c = _subborrow_u64(c, x, y, &difference);
+        memcpy(r + i, &difference, 8);
+    }
+    return limbs_sub_portable(r + i, a + i, b + i, n - i, c);
+}
+#endif
+
+#ifdef BIGINT_AVX2
+#ifdef BIGINT_X86_64
+#define limbs_add_scalar limbs_add_adc64
+#define limbs_sub_scalar limbs_sub_adc64
+#else
+#define limbs_add_scalar limbs_add_portable
+#define limbs_sub_scalar limbs_sub_portable
+#endif
+
+// Below this many limbs the vector setup costs more than it saves
+#define AVX2_MIN_LIMBS 32
+
+// Function to add eight limbs at a time with AVX2 and carry lookahead. The lanes are added without carries,
+// then every lane reports whether it generated a carry (the sum wrapped) or would propagate one (the sum is
+// all ones). With those as bit masks G and P, one integer addition P + (G << 1 | carry in) resolves the whole
+// chain: its bits differ from P exactly in the lanes that receive a carry, and bit 8 is the carry out.
+__attribute__((target("avx2"))) uint32_t limbs_add_avx2(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry)
+{
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i all_ones = _mm256_set1_epi32(-1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i lane_bits = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    if (n < AVX2_MIN_LIMBS)
+        return limbs_add_scalar(r, a, b, n, carry);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i sum = _mm256_add_epi32(x, y);
+
+        // Unsigned sum < x, compared as signed numbers with the sign bits flipped
+        __m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(x, sign), _mm256_xor_si256(sum, sign));
+        __m256i propagate = _mm256_cmpeq_epi32(sum, all_ones);
+        uint32_t g = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(generate));
+        uint32_t p = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(propagate));
+
+        uint32_t resolved = p + ((g << 1) | carry);
+        uint32_t carries = (resolved ^ p) & 0xFF;
+        carry = (resolved >> 8) & 1;
+
+        __m256i carry_in = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)carries), lane_bits), one);
+        _mm256_storeu_si256((__m256i *)(r + i), _mm256_add_epi32(sum, carry_in));
+    }
+    return limbs_add_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+// Function to subtract eight limbs at a time with AVX2 and borrow lookahead: a lane generates a borrow if
+// x < y and propagates one if x - y is zero
+__attribute__((target("avx2"))) uint32_t limbs_sub_avx2(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t borrow)
+{
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i lane_bits = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    if (n < AVX2_MIN_LIMBS)
+        return limbs_sub_scalar(r, a, b, n, borrow);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i difference = _mm256_sub_epi32(x, y);
+
+        __m256i generate = _mm256_cmpgt_epi32(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+        __m256i propagate = _mm256_cmpeq_epi32(difference, zero);
+        uint32_t g = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(generate));
+        uint32_t p = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(propagate));
+
+        uint32_t resolved = p + ((g << 1) | borrow);
+        uint32_t borrows = (resolved ^ p) & 0xFF;
+        borrow = (resolved >> 8) & 1;
+
+        __m256i borrow_in = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)borrows), lane_bits), one);
+        _mm256_storeu_si256((__m256i *)(r + i), _mm256_sub_epi32(difference, borrow_in));
+    }
+    return limbs_sub_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+#endif
+
+#ifdef BIGINT_AVX2
+// Function to add b to a limb by limb without propagating carries; carries[i] counts the carries out of limb i.
+// Every limb is independent, so 32 limbs are added per step and their carry masks are packed down to bytes.
+__attribute__((target("avx2"))) void carry_save_add_avx2(uint32_t *a, uint8_t *carries, const uint32_t *b, int n)
+{
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i byte_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7); // Undoes the lane interleaving of the packs
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i carry[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(a + i + 8 * k));
+            __m256i y = _mm256_loadu_si256((const __m256i *)(b + i + 8 * k));
+            __m256i sum = _mm256_add_epi32(x, y);
+            carry[k] = _mm256_cmpgt_epi32(_mm256_xor_si256(y, sign), _mm256_xor_si256(sum, sign)); // -1 where sum < y
+            _mm256_storeu_si256((__m256i *)(a + i + 8 * k), sum);
+        }
+
+        __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(carry[0], carry[1]), _mm256_packs_epi32(carry[2], carry[3]));
+        packed = _mm256_permutevar8x32_epi32(packed, byte_order);
+        __m256i counts = _mm256_loadu_si256((const __m256i *)(carries + i));
+        _mm256_storeu_si256((__m256i *)(carries + i), _mm256_sub_epi8(counts, packed));
+    }
+    for (; i < n; i++)
+    {
+        uint32_t sum = a[i] + b[i];
+        carries[i] += sum < b[i];
+        a[i] = sum;
+    }
+}
+#endif
+
+uint32_t limbs_add_select(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry);
+uint32_t limbs_sub_select(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t borrow);
+
+// Kernels in use. They start out as the selectors, which check the processor on the first call and replace themselves.
+LimbKernel limbs_add = limbs_add_select;
+LimbKernel limbs_sub = limbs_sub_select;
+const char *limb_kernel_name = "portable";
+
+// Carry-save addition, NULL if it would not be faster than the add kernel (a scalar carry-save loop is slower than
+// a scalar carry chain, so only vector units make it pay off)
+void (*carry_save_add)(uint32_t *a, uint8_t *carries, const uint32_t *b, int n) = NULL;
+
+// Function to pick the fastest add and subtract kernels the processor supports
+void select_limb_kernels()
+{
+    LimbKernel add = limbs_add_portable, sub = limbs_sub_portable;
+    const char *name = "portable";
+#ifdef BIGINT_X86_64
+    add = limbs_add_adc64;
+    sub = limbs_sub_adc64;
+    name = "adc64";
+#endif
+#ifdef BIGINT_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        add = limbs_add_avx2;
+        sub = limbs_sub_avx2;
+        name = "avx2";
+        carry_save_add = carry_save_add_avx2;
+    }
+#endif
+    limb_kernel_name = name;
+    limbs_sub = sub;
+    limbs_add = add;
+}
+
+// Function to select the kernels and run the addition with them
+uint32_t limbs_add_select(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry)
+{
+    select_limb_kernels();
+    return limbs_add(r, a, b, n, carry);
+}
+
+// Function to select the kernels and run the subtraction with them
+uint32_t limbs_sub_select(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t borrow)
+{
+    select_limb_kernels();
+    return limbs_sub(r, a, b, n, borrow);
+}
+
+// Function to add b (bn limbs) to a (an >= bn limbs) in place. Returns the carry out of a. b may be a.
+uint32_t mag_add_to(uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    uint32_t carry = limbs_add(a, a, b, bn, 0);
+    for (int i = bn; carry && i < an; i++)
+        carry = ++a[i] == 0;
+    return carry;
+}
+
+// Function to subtract b (bn limbs) from a (an >= bn limbs) in place. Returns the borrow out of a.
+uint32_t mag_sub_from(uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    uint32_t borrow = limbs_sub(a, a, b, bn, 0);
+    for (int i = bn; borrow && i < an; i++)
+        borrow = a[i]-- == 0;
+    return borrow;
+}
+
+// Function to compare two trimmed magnitudes, returning -1, 0 or 1
+int mag_compare(const uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    for (int i = an - 1; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Function to multiply with the schoolbook method. r (an + bn limbs) must not overlap a or b.
+void mag_mul_schoolbook(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    for (int j = 0; j < bn; j++)
+    {
+        uint64_t carry = 0;
+        uint32_t bj = b[j];
+        if (bj == 0)
+            continue;
+        for (int i = 0; i < an; i++)
+        {
+            carry += (uint64_t)a[i] * bj + r[i + j];
+            r[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        r[j + an] = (uint32_t)carry;
+    }
+}
+
+void mag_mul(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn);
+
+// Function to multiply operands of similar size with Karatsuba's method (an >= bn > an / 2). Splitting both at
+// h limbs, a * b = z2 * B^2h + z1 * B^h + z0 with z0 = a0 * b0, z2 = a1 * b1 and z1 = (a0 + a1)(b0 + b1) - z0 - z2,
+// which takes three half-size products instead of four.
+void mag_mul_karatsuba(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    int h = (an + 1) / 2;
+    int a1n = an - h;
+    int b1n = bn - h; // At least 0 and at most a1n, since bn > an / 2 and bn <= an
+
+    // z0 and z2 go straight into the low and high parts of the result
+    mag_mul(r, a, h, b, h);
+    if (b1n > 0)
+        mag_mul(r + 2 * h, a + h, a1n, b + h, b1n);
+    else
+        memset(r + 2 * h, 0, a1n * sizeof(uint32_t));
+
+    uint32_t *sa = memory_alloc((4 * h + 4) * sizeof(uint32_t));
+    uint32_t *sb = sa + h + 1;
+    uint32_t *z1 = sb + h + 1;
+
+    memcpy(sa, a, h * sizeof(uint32_t));
+    sa[h] = mag_add_to(sa, h, a + h, a1n);
+    memcpy(sb, b, h * sizeof(uint32_t));
+    sb[h] = mag_add_to(sb, h, b + h, b1n);
+
+    mag_mul(z1, sa, h + 1, sb, h + 1);
+    mag_sub_from(z1, 2 * h + 2, r, 2 * h);
+    mag_sub_from(z1, 2 * h + 2, r + 2 * h, a1n + b1n);
+
+    // z1 fits in the result above B^h, but its array may have a few more (zero) limbs
+    int z1n = 2 * h + 2;
+    while (z1n > 0 && z1[z1n - 1] == 0)
+        z1n--;
+    mag_add_to(r + h, an + bn - h, z1, z1n);
+
+    memory_free(sa, (4 * h + 4) * sizeof(uint32_t));
+}
+
+// Function to multiply two magnitudes into r (an + bn limbs), which must not overlap a or b
+void mag_mul(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    if (an < bn)
+    {
+        const uint32_t *t = a;
+        a = b;
+        b = t;
+        int tn = an;
+        an = bn;
+        bn = tn;
+    }
+
+    if (bn < karatsuba_cutoff)
+    {
+        mag_mul_schoolbook(r, a, an, b, bn);
+        return;
+    }
+
+    // The transform pads to a power of two anyway, so unbalanced operands need no slicing
+    if (bn >= ntt_cutoff && an + bn <= NTT_MAX_LIMBS)
+    {
+        mag_mul_ntt(r, a, an, b, bn);
+        return;
+    }
+
+    if (2 * bn <= an)
+    {
+        // Very different sizes: multiply b by bn-limb slices of a, so each product is balanced
+        uint32_t *t = memory_alloc(2 * bn * sizeof(uint32_t));
+        memset(r, 0, (an + bn) * sizeof(uint32_t));
+        for (int i = 0; i < an; i += bn)
+        {
+            int len = an - i < bn ? an - i : bn;
+            mag_mul(t, a + i, len, b, bn);
+            mag_add_to(r + i, an + bn - i, t, len + bn);
+        }
+        memory_free(t, 2 * bn * sizeof(uint32_t));
+        return;
+    }
+
+    mag_mul_karatsuba(r, a, an, b, bn);
+}
+
+// Function to divide with Knuth's algorithm D (as given in Hacker's Delight). u has m limbs and v has n limbs,
+// with m >= n >= 2 and v[n - 1] != 0. Writes m - n + 1 quotient limbs to q and n remainder limbs to r.
+void mag_divmod_knuth(uint32_t *q, uint32_t *r, const uint32_t *u, int m, const uint32_t *v, int n)
+{
+    const uint64_t base = 1ULL << 32;
+
+    // Normalize so the top bit of the divisor is set, which keeps the quotient estimates off by at most 2
+    int s = 0;
+    while (!(v[n - 1] & (0x80000000u >> s)))
+        s++;
+
+    uint32_t *vn = memory_alloc((n + m + 1) * sizeof(uint32_t));
+    uint32_t *un = vn + n;
+    for (int i = n - 1; i > 0; i--)
+        vn[i] = (v[i] << s) | (uint32_t)((uint64_t)v[i - 1] >> (32 - s));
+    vn[0] = v[0] << s;
+    un[m] = (uint32_t)((uint64_t)u[m - 1] >> (32 - s));
+    for (int i = m - 1; i > 0; i--)
+        un[i] = (u[i] << s) | (uint32_t)((uint64_t)u[i - 1] >> (32 - s));
+    un[0] = u[0] << s;
+
+    for (int j = m - n; j >= 0; j--)
+    {
+        // Estimate the quotient limb from the top two limbs and correct it with the third
+        uint64_t num = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num % vn[n - 1];
+        while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2]))
+        {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >= base)
+                break;
+        }
+
+        // Multiply and subtract
+        int64_t t;
+        int64_t k = 0;
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t p = qhat * vn[i];
+            t = (int64_t)un[i + j] - k - (int64_t)(p & 0xFFFFFFFFu);
+            un[i + j] = (uint32_t)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)un[j + n] - k;
+        un[j + n] = (uint32_t)t;
+
+        // The estimate was one too large: add the divisor back
+        q[j] = (uint32_t)qhat;
+        if (t < 0)
+        {
+            q[j]--;
+            uint64_t carry = 0;
+            for (int i = 0; i < n; i++)
+            {
+                carry += (uint64_t)un[i + j] + vn[i];
+                un[i + j] = (uint32_t)carry;
+                carry >>= 32;
+            }
+            un[j + n] += (uint32_t)carry;
+        }
+    }
+
+    // Undo the normalization of the remainder
+    for (int i = 0; i < n - 1; i++)
+        r[i] = (un[i] >> s) | (uint32_t)((uint64_t)un[i + 1] << (32 - s));
+    r[n - 1] = un[n - 1] >> s;
+
+    memory_free(vn, (n + m + 1) * sizeof(uint32_t));
+}
+
+// Function to set dst to the limbs [from, to) of src, i.e. (src / B^from) mod B^(to - from)
+void bigint_slice(BigInt *dst, const BigInt *src, int from, int to)
+{
+    if (to > src->length)
+        to = src->length;
+    int n = to > from ? to - from : 0;
+
+    bigint_reserve(dst, n);
+    if (n > 0)
+        memmove(dst->limbs, src->limbs + from, n * sizeof(uint32_t));
+    dst->length = n;
+    dst->negative = 0;
+    bigint_trim(dst);
+}
+
+// Function to set dst = high * B^n + low, where low is below B^n. dst must not be high or low.
+void bigint_join(BigInt *dst, const BigInt *high, const BigInt *low, int n)
+{
+    int length = high->length > 0 ? n + high->length : low->length;
+
+    bigint_reserve(dst, length);
+    if (low->length > 0)
+        memcpy(dst->limbs, low->limbs, low->length * sizeof(uint32_t));
+    if (high->length > 0)
+    {
+        memset(dst->limbs + low->length, 0, (n - low->length) * sizeof(uint32_t));
+        memcpy(dst->limbs + n, high->limbs, high->length * sizeof(uint32_t));
+    }
+    dst->length = length;
+    dst->negative = 0;
+}
+
+// Function to return the number of significant bits of the magnitude
+long long bigint_bit_length(const BigInt *a)
+{
+    if (a->length == 0)
+        return 0;
+
+    long long bits = (long long)(a->length - 1) * 32;
+    for (uint32_t top = a->limbs[a->length - 1]; top; top >>= 1)
+        bits++;
+    return bits;
+}
+
+// Function to set dst to the magnitude of src shifted left by the given number of bits
+void bigint_shift_left(BigInt *dst, const BigInt *src, int bits)
+{
+    int limbs = bits / 32;
+    int s = bits % 32;
+    int n = src->length;
+
+    BigInt result = {0};
+    bigint_reserve(&result, n + limbs + 1);
+    memset(result.limbs, 0, limbs * sizeof(uint32_t));
+    uint32_t carry = 0;
+    for (int i = 0; i < n; i++)
+    {
+        result.limbs[i + limbs] = (src->limbs[i] << s) | carry;
+        carry = s ? src->limbs[i] >> (32 - s) : 0;
+    }
+    result.limbs[n + limbs] = carry;
+    result.length = n + limbs + 1;
+    bigint_trim(&result);
+
+    bigint_free(dst);
+    *dst = result;
+}
+
+// Function to shift the magnitude of a right by the given number of bits (less than 32) in place
+void bigint_shift_right(BigInt *a, int bits)
+{
+    if (bits == 0)
+        return;
+
+    for (int i = 0; i < a->length; i++)
+    {
+        uint32_t next = i + 1 < a->length ? a->limbs[i + 1] : 0;
+        a->limbs[i] = (a->limbs[i] >> bits) | (next << (32 - bits));
+    }
+    bigint_trim(a);
+}
+
+// Function to divide magnitudes with the schoolbook method: q = |a| / |b|, r = |a| mod |b|. b must not be zero.
+void divmod_schoolbook(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b)
+{
+    int m = a->length;
+    int n = b->length;
+
+    if (mag_compare(a->limbs, m, b->limbs, n) < 0)
+    {
+        bigint_copy(r, a);
+        r->negative = 0;
+        bigint_set_ll(q, 0);
+        return;
+    }
+
+    BigInt quotient = {0}, remainder = {0};
+    bigint_reserve(&quotient, m - n + 1);
+    bigint_reserve(&remainder, n);
+
+    if (n == 1)
+    {
+        memcpy(quotient.limbs, a->limbs, m * sizeof(uint32_t));
+        remainder.limbs[0] = mag_div_small(quotient.limbs, m, b->limbs[0]);
+    }
+    else
+    {
+        mag_divmod_knuth(quotient.limbs, remainder.limbs, a->limbs, m, b->limbs, n);
+    }
+    quotient.length = m - n + 1;
+    remainder.length = n;
+    bigint_trim(&quotient);
+    bigint_trim(&remainder);
+
+    bigint_free(q);
+    bigint_free(r);
+    *q = quotient;
+    *r = remainder;
+}
+
+void divide_3n_by_2n(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b, int half);
+
+// Burnikel-Ziegler: divides a by b, where b has exactly n limbs with the top bit set and a < b * B^n.
+// The division is done as two 3-by-2 block divisions, each of which recurses on a half-size divisor.
+void divide_2n_by_1n(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b, int n)
+{
+    if (n % 2 != 0 || n < BURNIKEL_ZIEGLER_CUTOFF)
+    {
+        divmod_schoolbook(q, r, a, b);
+        return;
+    }
+
+    int half = n / 2;
+    BigInt top = {0}, low = {0}, q1 = {0}, q2 = {0}, r1 = {0}, next = {0};
+
+    // a = [a1 a2 a3 a4] in half-size blocks: [a1 a2 a3] / b gives the high quotient half, [r1 a4] / b the low one
+    bigint_slice(&top, a, half, a->length);
+    bigint_slice(&low, a, 0, half);
+    divide_3n_by_2n(&q1, &r1, &top, b, half);
+    bigint_join(&next, &r1, &low, half);
+    divide_3n_by_2n(&q2, r, &next, b, half);
+    bigint_join(&top, &q1, &q2, half);
+    bigint_copy(q, &top);
+
+    bigint_free(&top);
+    bigint_free(&low);
+    bigint_free(&q1);
+    bigint_free(&q2);
+    bigint_free(&r1);
+    bigint_free(&next);
+}
+
+// Burnikel-Ziegler: divides a (up to 3 * half limbs) by b = [b1 b2] (2 * half limbs, top bit set), with a < b * B^half
+void divide_3n_by_2n(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b, int half)
+{
+    BigInt a1 = {0}, a12 = {0}, a3 = {0}, b1 = {0}, b2 = {0}, r1 = {0}, d = {0}, rhat = {0};
+
+    bigint_slice(&a1, a, 2 * half, a->length);
+    bigint_slice(&a12, a, half, a->length);
+    bigint_slice(&a3, a, 0, half);
+    bigint_slice(&b1, b, half, b->length);
+    bigint_slice(&b2, b, 0, half);
+
+    // Estimate the quotient from the top blocks: [a1 a2] / b1, or B^half - 1 when a1 = b1 (the quotient cannot be larger)
+    if (bigint_compare(&a1, &b1) < 0)
+    {
+        divide_2n_by_1n(q, &r1, &a12, &b1, half);
+    }
+    else
+    {
+        BigInt shifted = {0};
+        bigint_join(&shifted, &b1, &d, half); // b1 * B^half (d is still zero)
+        bigint_reserve(q, half);
+        for (int i = 0; i < half; i++)
+            q->limbs[i] = 0xFFFFFFFFu;
+        q->length = half;
+        q->negative = 0;
+        bigint_copy(&r1, &a12);
+        bigint_sub(&r1, &shifted);
+        bigint_add(&r1, &b1);
+        bigint_free(&shifted);
+    }
+
+    // The estimate is at most 2 too large; correct it so the remainder [r1 a3] - q * b2 is not negative
+    bigint_copy(&d, q);
+    bigint_mul(&d, &b2);
+    bigint_join(&rhat, &r1, &a3, half);
+    while (bigint_compare(&rhat, &d) < 0)
+    {
+        bigint_add(&rhat, b);
+        BigInt one = {0};
+        bigint_set_ll(&one, 1);
+        bigint_sub(q, &one);
+        bigint_free(&one);
+    }
+    bigint_sub(&rhat, &d);
+    bigint_copy(r, &rhat);
+
+    bigint_free(&a1);
+    bigint_free(&a12);
+    bigint_free(&a3);
+    bigint_free(&b1);
+    bigint_free(&b2);
+    bigint_free(&r1);
+    bigint_free(&d);
+    bigint_free(&rhat);
+}
+
+// Function to divide magnitudes with Burnikel-Ziegler recursive division. The divisor is padded to n = j * 2^k limbs
+// (j below the cutoff) and normalized, and the dividend is divided in n-limb blocks from the top.
+void divmod_burnikel_ziegler(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b)
+{
+    int m = 1;
+    while (m * BURNIKEL_ZIEGLER_CUTOFF < b->length)
+        m *= 2;
+    int n = (b->length + m - 1) / m * m;
+    int shift = (int)((long long)n * 32 - bigint_bit_length(b));
+
+    BigInt bb = {0}, aa = {0}, z = {0}, block = {0}, qi = {0}, ri = {0}, quotient = {0}, next = {0};
+    bigint_shift_left(&bb, b, shift);
+    bigint_shift_left(&aa, a, shift);
+
+    // Enough blocks that the top one is below the divisor
+    int t = (int)((bigint_bit_length(&aa) + (long long)n * 32) / ((long long)n * 32));
+    if (t < 2)
+        t = 2;
+
+    bigint_slice(&z, &aa, (t - 2) * n, aa.length);
+    for (int i = t - 2; i >= 0; i--)
+    {
+        divide_2n_by_1n(&qi, &ri, &z, &bb, n);
+        bigint_join(&next, &quotient, &qi, n);
+        bigint_copy(&quotient, &next);
+        if (i > 0)
+        {
+            bigint_slice(&block, &aa, (i - 1) * n, i * n);
+            bigint_join(&z, &ri, &block, n);
+        }
+    }
+
+    // Undo the normalization of the remainder
+    bigint_slice(&next, &ri, shift / 32, ri.length);
+    bigint_shift_right(&next, shift % 32);
+    bigint_copy(r, &next);
+    bigint_copy(q, &quotient);
+
+    bigint_free(&bb);
+    bigint_free(&aa);
+    bigint_free(&z);
+    bigint_free(&block);
+    bigint_free(&qi);
+    bigint_free(&ri);
+    bigint_free(&quotient);
+    bigint_free(&next);
+}
+
+// Function to divide magnitudes, choosing the algorithm by size: q = |a| / |b|, r = |a| mod |b|
+void divmod_magnitude(BigInt *q, BigInt *r, const BigInt *a, const BigInt *b)
+{
+    if (b->length >= BURNIKEL_ZIEGLER_CUTOFF && a->length - b->length >= BURNIKEL_ZIEGLER_CUTOFF / 2)
+        divmod_burnikel_ziegler(q, r, a, b);
+    else
+        divmod_schoolbook(q, r, a, b);
+}
+
+#ifdef BIGINT_LITTLE_ENDIAN
+// Function to convert eight decimal digits at once: neighbouring digits are combined into pairs, pairs into
+// groups of four and those into the result, with three multiplications instead of eight (SWAR)
+uint32_t eight_digits(const char *s)
+{
+    uint64_t v;
+    memcpy(&v, s, 8);
+    v -= 0x3030303030303030ULL;
+    v = v * 10 + (v >> 8);
+    v = ((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+         ((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+    return (uint32_t)v;
+}
+#endif
+
+// Powers of ten that fit in 64 bits
+const uint64_t powers_of_ten[20] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+                                    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+                                    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                                    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL};
+
+// Function to convert up to 19 decimal digits to their value
+uint64_t decimal_chunk(const char *s, int n)
+{
+    uint64_t value = 0;
+#ifdef BIGINT_LITTLE_ENDIAN
+    for (; n >= 8; n -= 8, s += 8)
+        value = value * 100000000 + eight_digits(s);
+#endif
+    for (; n > 0; n--)
+        value = value * 10 + (uint64_t)(*s++ - '0');
+    return value;
+}
+
+// Function to set a number from decimal digits. They are consumed in chunks of 19, the most that fit in 64 bits,
+// so a number takes half the passes over its limbs that chunks of 9 would: a = a * 10^19 + chunk
+void bigint_from_digits(BigInt *a, const char *digits, size_t n, int negative)
+{
+    bigint_reserve(a, (int)(n / 9) + 2);
+    a->length = 0;
+
+    size_t chunk_digits = n % 19 ? n % 19 : 19;
+    for (size_t i = 0; i < n; i += chunk_digits, chunk_digits = 19)
+    {
+        uint64_t chunk = decimal_chunk(digits + i, (int)chunk_digits);
+        uint64_t carry = mag_mul_small64(a->limbs, a->length, powers_of_ten[chunk_digits], chunk);
+        for (; carry; carry >>= 32)
+            a->limbs[a->length++] = (uint32_t)carry;
+    }
+
+    a->negative = negative;
+    bigint_trim(a);
+}
+
+// Function to set a number from a decimal string with an optional sign
+int bigint_parse(BigInt *a, const char *s)
+{
+    int negative = 0;
+    if (*s == '-' || *s == '+')
+        negative = *s++ == '-';
+
+    size_t digits = strlen(s);
+    a->length = 0;
+    a->negative = 0;
+    if (digits == 0)
+        return 0;
+    for (size_t i = 0; i < digits; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+            return 0;
+    }
+
+    bigint_from_digits(a, s, digits, negative);
+    return 1;
+}
+
+// Function to check whether the value fits in a long long, storing it if it does
+int bigint_to_ll(const BigInt *a, long long *value)
+{
+    if (a->length > 2)
+        return 0;
+
+    unsigned long long magnitude = 0;
+    if (a->length > 0)
+        magnitude = a->limbs[0];
+    if (a->length > 1)
+        magnitude |= (unsigned long long)a->limbs[1] << 32;
+
+    if (!a->negative && magnitude <= (unsigned long long)LLONG_MAX)
+        *value = (long long)magnitude;
+    else if (a->negative && magnitude <= (unsigned long long)LLONG_MAX + 1)
+        *value = magnitude == (unsigned long long)LLONG_MAX + 1 ? LLONG_MIN : -(long long)magnitude;
+    else
+        return 0;
+    return 1;
+}
+
+// Function to convert to a long long, clamping values outside its range
+long long bigint_clamp(const BigInt *a)
+{
+    long long value;
+    if (bigint_to_ll(a, &value))
+        return value;
+    return a->negative ? LLONG_MIN : LLONG_MAX;
+}
+
+// Function to compare two numbers
+int bigint_compare(const BigInt *a, const BigInt *b)
+{
+    if (a->negative != b->negative)
+        return a->negative ? -1 : 1;
+
+    int c = mag_compare(a->limbs, a->length, b->limbs, b->length);
+    return a->negative ? -c : c;
+}
+
+// Function to get a buffer size for the decimal representation (at most 10 digits per limb, sign and terminator)
+size_t bigint_decimal_size(const BigInt *a)
+{
+    return (size_t)a->length * 10 + 3;
+}
+
+// Function to write the decimal representation, by repeatedly dividing a copy of the magnitude by 10^9
+size_t bigint_to_decimal(const BigInt *a, char *buf)
+{
+    if (a->length == 0)
+    {
+        strcpy(buf, "0");
+        return 1;
+    }
+
+    int n = a->length;
+    size_t work_size = n * sizeof(uint32_t), chunks_size = (n * 10 / 9 + 2) * sizeof(uint32_t);
+    uint32_t *work = memory_alloc(work_size);
+    uint32_t *chunks = memory_alloc(chunks_size);
+    int count = 0;
+    memcpy(work, a->limbs, n * sizeof(uint32_t));
+
+    do
+    {
+        chunks[count++] = mag_div_small(work, n, 1000000000u);
+        while (n > 0 && work[n - 1] == 0)
+            n--;
+    } while (n > 0);
+
+    // The most significant chunk is written without leading zeros, the others with exactly 9 digits
+    size_t len = 0;
+    if (a->negative)
+        buf[len++] = '-';
+    len += sprintf(buf + len, "%u", chunks[count - 1]);
+    for (int i = count - 2; i >= 0; i--)
+        len += sprintf(buf + len, "%09u", chunks[i]);
+
+    memory_free(work, work_size);
+    memory_free(chunks, chunks_size);
+    return len;
+}
+
+// Function to add b with the given sign to a
+void add_signed(BigInt *a, const BigInt *b, int b_negative)
+{
+    if (b->length == 0)
+        return;
+
+    // Fast path for adding a single limb of the same sign, the common case of counters and sums in loops
+    if (b->length == 1 && a->length > 0 && a->negative == b_negative)
+    {
+        uint32_t sum = a->limbs[0] + b->limbs[0];
+        int carry = sum < a->limbs[0];
+        a->limbs[0] = sum;
+
+        int i = 1;
+        while (carry && i < a->length)
+            carry = ++a->limbs[i++] == 0;
+        if (carry)
+        {
+            bigint_reserve(a, a->length + 1);
+            a->limbs[a->length++] = 1;
+        }
+        return;
+    }
+
+    if (a->length == 0 || a->negative == b_negative)
+    {
+        // Same signs: add the magnitudes
+        int n = a->length > b->length ? a->length : b->length;
+        bigint_reserve(a, n + 1);
+        if (a->length < n)
+            memset(a->limbs + a->length, 0, (n - a->length) * sizeof(uint32_t));
+        a->limbs[n] = mag_add_to(a->limbs, n, b->limbs, b->length);
+        a->length = n + 1;
+        a->negative = b_negative;
+        bigint_trim(a);
+    }
+    else if (mag_compare(a->limbs, a->length, b->limbs, b->length) >= 0)
+    {
+        // Different signs, |a| >= |b|: the sign of a stays
+        mag_sub_from(a->limbs, a->length, b->limbs, b->length);
+        bigint_trim(a);
+    }
+    else
+    {
+        // Different signs, |a| < |b|: a = b - a, with the sign of b
+        int n = b->length;
+        bigint_reserve(a, n);
+        memset(a->limbs + a->length, 0, (n - a->length) * sizeof(uint32_t));
+        limbs_sub(a->limbs, b->limbs, a->limbs, n, 0);
+        a->length = n;
+        a->negative = b_negative;
+        bigint_trim(a);
+    }
+}
+
+// Function to add b to a
+void bigint_add(BigInt *a, const BigInt *b)
+{
+    add_signed(a, b, b->negative);
+}
+
+// Function to subtract b from a
+void bigint_sub(BigInt *a, const BigInt *b)
+{
+    add_signed(a, b, !b->negative);
+}
+
+// Function to make room in cs for a carry counter per limb of a
+void reserve_carries(const BigInt *a, CarrySave *cs)
+{
+    if (cs->capacity >= a->length)
+        return;
+
+    int capacity = a->capacity;
+    cs->carries = memory_realloc(cs->carries, cs->capacity, capacity);
+    memset(cs->carries + cs->capacity, 0, capacity - cs->capacity);
+    cs->capacity = capacity;
+}
+
+// Function to add b to a with the carries left pending in cs
+int bigint_add_deferred(BigInt *a, CarrySave *cs, const BigInt *b, int negate)
+{
+    if (limbs_add == limbs_add_select)
+        select_limb_kernels(); // The kernels are normally picked by the first addition
+    if (b == a || b->length == 0)
+        return 0;
+
+    int b_negative = b->negative ^ negate;
+    int same_sign = a->length == 0 || a->negative == b_negative;
+
+    if (same_sign && carry_save_add && b->length >= CARRY_SAVE_MIN_LIMBS)
+    {
+        if (cs->pending == 255)
+            bigint_settle(a, cs); // The next carry could overflow a counter
+
+        if (a->length < b->length)
+        {
+            bigint_reserve(a, b->length);
+            memset(a->limbs + a->length, 0, (b->length - a->length) * sizeof(uint32_t));
+            a->length = b->length;
+        }
+        reserve_carries(a, cs);
+
+        a->negative = b_negative;
+        carry_save_add(a->limbs, cs->carries, b->limbs, b->length);
+        cs->pending++;
+        return 1;
+    }
+
+    // A normal number gains nothing here; the caller's addition is just as fast
+    if (!cs->pending || b->length > a->length)
+        return 0;
+
+    // Short or opposite-sign updates go straight into the limb-wise sums, so a loop that mixes them with wide
+    // additions does not have to propagate the carries every time
+    if (same_sign)
+    {
+        if (mag_add_to(a->limbs, a->length, b->limbs, b->length))
+        {
+            bigint_reserve(a, a->length + 1);
+            a->limbs[a->length++] = 1;
+            reserve_carries(a, cs);
+        }
+        return 1;
+    }
+    if (mag_sub_from(a->limbs, a->length, b->limbs, b->length))
+    {
+        mag_add_to(a->limbs, a->length, b->limbs, b->length); // Undo: b is larger than the sums without their carries
+        return 0;
+    }
+    return 1;
+}
+
+// Function to propagate the pending carries of a
+void bigint_settle(BigInt *a, CarrySave *cs)
+{
+    if (!cs->pending)
+        return;
+
+    uint64_t carry = 0;
+    for (int i = 0; i < a->length; i++)
+    {
+        carry += a->limbs[i];
+        a->limbs[i] = (uint32_t)carry;
+        carry = (carry >> 32) + cs->carries[i];
+        cs->carries[i] = 0;
+    }
+    if (carry)
+    {
+        bigint_reserve(a, a->length + 1);
+        a->limbs[a->length++] = (uint32_t)carry;
+    }
+    cs->pending = 0;
+    bigint_trim(a);
+}
+
+// Function to free the carry counters
+void carry_save_free(CarrySave *cs)
+{
+    memory_free(cs->carries, cs->capacity);
+    cs->carries = NULL;
+    cs->capacity = 0;
+    cs->pending = 0;
+}
+
+// Function to multiply a by b
+void bigint_mul(BigInt *a, const BigInt *b)
+{
+    if (a->length == 0 || b->length == 0)
+    {
+        a->length = 0;
+        a->negative = 0;
+        return;
+    }
+
+    // Single-limb factor: multiply in place
+    if (b->length == 1 && a != b)
+    {
+        bigint_reserve(a, a->length + 1);
+        uint32_t carry = mag_mul_small(a->limbs, a->length, b->limbs[0], 0);
+        if (carry)
+            a->limbs[a->length++] = carry;
+        a->negative ^= b->negative;
+        return;
+    }
+
+    int n = a->length + b->length;
+    uint32_t *product = memory_alloc(n * sizeof(uint32_t));
+    mag_mul(product, a->limbs, a->length, b->limbs, b->length);
+
+    a->negative ^= b->negative;
+    memory_free(a->limbs, a->capacity * sizeof(uint32_t));
+    a->limbs = product;
+    a->capacity = n;
+    a->length = n;
+    bigint_trim(a);
+}
+
+// Function to divide a by b (quotient rounded toward zero) or take the remainder, which has the sign of a
+int divide(BigInt *a, const BigInt *b, int want_remainder)
+{
+    if (b->length == 0)
+        return BIGINT_DIVISION_BY_ZERO;
+
+    if (a->length == 0)
+        return BIGINT_OK; // 0 / b = 0 % b = 0
+
+    int negative = want_remainder ? a->negative : a->negative ^ b->negative;
+
+    // Single-limb divisor: divide in place
+    if (b->length == 1)
+    {
+        uint32_t rem = mag_div_small(a->limbs, a->length, b->limbs[0]);
+        if (want_remainder)
+        {
+            a->limbs[0] = rem;
+            a->length = 1;
+        }
+        a->negative = negative;
+        bigint_trim(a);
+        return BIGINT_OK;
+    }
+
+    BigInt q = {0}, r = {0};
+    divmod_magnitude(&q, &r, a, b);
+    if (want_remainder)
+    {
+        bigint_free(a);
+        *a = r;
+        bigint_free(&q);
+    }
+    else
+    {
+        bigint_free(a);
+        *a = q;
+        bigint_free(&r);
+    }
+    a->negative = negative;
+    bigint_trim(a);
+    return BIGINT_OK;
+}
+
+// Function to divide a by b
+int bigint_div(BigInt *a, const BigInt *b)
+{
+    return divide(a, b, 0);
+}
+
+// Function to set a to the remainder of a divided by b
+int bigint_mod(BigInt *a, const BigInt *b)
+{
+    return divide(a, b, 1);
+}
+
+// Function to raise a to the power b by square-and-multiply
+int bigint_pow(BigInt *a, const BigInt *b)
+{
+    if (b->negative)
+        return BIGINT_NEGATIVE_EXPONENT;
+
+    // x^0 = 1 (including 0^0), 0^n = 0 and (+-1)^n = +-1 need no work, however large the exponent is
+    if (b->length == 0)
+    {
+        bigint_set_ll(a, 1);
+        return BIGINT_OK;
+    }
+    if (a->length == 0)
+        return BIGINT_OK;
+    if (a->length == 1 && a->limbs[0] == 1)
+    {
+        a->negative = a->negative && (b->limbs[0] & 1);
+        return BIGINT_OK;
+    }
+
+    // |a| >= 2, so the result has at least exponent * (bits of a - 1) bits
+    if (b->length > 1)
+        return BIGINT_TOO_LARGE;
+    uint32_t exponent = b->limbs[0];
+    if ((uint64_t)exponent * (uint64_t)(bigint_bit_length(a) - 1) > (uint64_t)BIGINT_MAX_LIMBS * 32)
+        return BIGINT_TOO_LARGE;
+
+    // Left-to-right binary powering: square for every bit below the top one and multiply by the base for every 1 bit
+    BigInt base = {0};
+    bigint_copy(&base, a);
+    int bit = 31;
+    while (!(exponent >> bit & 1))
+        bit--;
+    for (bit--; bit >= 0; bit--)
+    {
+        bigint_mul(a, a);
+        if (exponent >> bit & 1)
+            bigint_mul(a, &base);
+    }
+    bigint_free(&base);
+    return BIGINT_OK;
+}
+
+// Function to describe a failed operation
+const char *bigint_error(int status)
+{
+    switch (status)
+    {
+    case BIGINT_DIVISION_BY_ZERO:
+        return "Division by zero.";
+    case BIGINT_NEGATIVE_EXPONENT:
+        return "Negative exponent.";
+    case BIGINT_TOO_LARGE:
+        return "Result is too large.";
+    default:
+        return "Arithmetic error.";
+    }
+}
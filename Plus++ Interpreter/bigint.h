@@ -0,0 +1,127 @@
+// bigint.h
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Arbitrary precision integer stored as sign and magnitude. The magnitude is kept in base 2^32 limbs,
+// least significant limb first. A zero-initialized BigInt ({0}) is a valid zero.
+typedef struct
+{
+    int negative;    // 1 if the value is below zero (zero is never negative)
+    int length;      // Number of limbs in use: 0 for zero, otherwise the top limb is not 0
+    int capacity;    // Number of limbs allocated
+    uint32_t *limbs; // Magnitude, least significant limb first
+} BigInt;
+
+// Results of the operations that can fail
+#define BIGINT_OK 0
+#define BIGINT_DIVISION_BY_ZERO 1
+#define BIGINT_NEGATIVE_EXPONENT 2
+#define BIGINT_TOO_LARGE 3
+
+// Operand size in limbs from which multiplication switches from schoolbook to Karatsuba
+#define KARATSUBA_CUTOFF 32
+
+// Multiplication cutoffs in use, KARATSUBA_CUTOFF and NTT_CUTOFF unless changed
+extern int karatsuba_cutoff;
+extern int ntt_cutoff;
+
+// Divisor size in limbs from which division switches from schoolbook (Knuth's algorithm D) to Burnikel-Ziegler
+#define BURNIKEL_ZIEGLER_CUTOFF 80
+
+// Largest result a power may produce, in limbs (2^26 limbs = 256 MB)
+#define BIGINT_MAX_LIMBS (1 << 26)
+
+// Kernel computing r = a + b + carry (or r = a - b - borrow) over n limbs and returning the carry (borrow) out
+typedef uint32_t (*LimbKernel)(uint32_t *r, const uint32_t *a, const uint32_t *b, int n, uint32_t carry);
+
+// Add and subtract kernels, picked for the processor on first use: AVX2 carry lookahead, 64-bit add-with-carry
+// or portable C
+extern LimbKernel limbs_add;
+extern LimbKernel limbs_sub;
+
+// Name of the kernels picked ("avx2", "adc64" or "portable"), valid after the first addition or subtraction
+extern const char *limb_kernel_name;
+
+// Pending carries of a number that is being summed up in carry-save form. While additions are pending, the limbs of
+// the number hold limb-wise sums without carries (and may have zero top limbs), and carries[i] counts the carries out
+// of limb i that still have to be added to limb i + 1. Such a number must be settled before anything else uses it.
+typedef struct
+{
+    uint8_t *carries;
+    int capacity; // Entries allocated in carries; the ones not pending are always 0
+    int pending;  // Additions since the carries were last propagated, 0 if the number is normal
+} CarrySave;
+
+// Smallest addend in limbs that is added in carry-save form; shorter ones are cheaper to add directly
+#define CARRY_SAVE_MIN_LIMBS 16
+
+// Makes room for at least n limbs, keeping the current value
+void bigint_reserve(BigInt *a, int n);
+
+// Frees the limbs of a number and sets it to zero
+void bigint_free(BigInt *a);
+
+// Sets a number from a machine integer
+void bigint_set_ll(BigInt *a, long long value);
+
+// Copies src into dst
+void bigint_copy(BigInt *dst, const BigInt *src);
+
+// Sets a number from a decimal string with an optional sign. Returns 0 if the string is not a number.
+int bigint_parse(BigInt *a, const char *s);
+
+// Sets a number from n decimal digits, which must all be '0' to '9', and a sign
+void bigint_from_digits(BigInt *a, const char *digits, size_t n, int negative);
+
+// Returns the value as a long long, clamped to the range of long long
+long long bigint_clamp(const BigInt *a);
+
+// Returns 1 if the value fits in a long long and stores it in *value, 0 otherwise
+int bigint_to_ll(const BigInt *a, long long *value);
+
+// Compares two numbers, returning -1, 0 or 1
+int bigint_compare(const BigInt *a, const BigInt *b);
+
+// Returns the size of a buffer large enough for the decimal representation, including sign and terminator
+size_t bigint_decimal_size(const BigInt *a);
+
+// Writes the decimal representation into buf and returns its length
+size_t bigint_to_decimal(const BigInt *a, char *buf);
+
+// a += b
+void bigint_add(BigInt *a, const BigInt *b);
+
+// a -= b
+void bigint_sub(BigInt *a, const BigInt *b);
+
+// a *= b
+void bigint_mul(BigInt *a, const BigInt *b);
+
+// a /= b, rounding toward zero
+int bigint_div(BigInt *a, const BigInt *b);
+
+// a %= b; the remainder has the sign of a
+int bigint_mod(BigInt *a, const BigInt *b);
+
+// a = a to the power of b
+int bigint_pow(BigInt *a, const BigInt *b);
+
+// a += b (a -= b if negate is set) where a may have carries pending in cs. Wide additions of the same sign are
+// done in carry-save form (if the processor has a vector kernel for it), and other updates of a number with pending
+// carries are applied to its limb-wise sums. Returns 0 without changing anything if neither is possible; the
+// caller then settles a and adds normally.
+int bigint_add_deferred(BigInt *a, CarrySave *cs, const BigInt *b, int negate);
+
+// Propagates the pending carries of a, leaving a normal number
+void bigint_settle(BigInt *a, CarrySave *cs);
+
+// Frees the carry counters
+void carry_save_free(CarrySave *cs);
+
+// Returns the error message for a failed operation
+const char *bigint_error(int status);
+
+#endif
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "lexer.h"
+#include "output.h"
+#include "module.h"
+
+// Header at the start of every .pppc file. The token records follow it directly,
+// so the whole file has a fixed layout and can be read (or mapped) without any fix-ups.
+typedef struct
+{
+    char magic[4];        // Always "PPPC"
+    uint32_t version;     // PPP_VERSION of the interpreter that wrote the file
+    uint32_t token_size;  // sizeof(Token), to reject caches written by a different build
+    uint32_t token_count; // Number of Token records following the header
+    uint64_t source_hash; // Hash of the source file the tokens were produced from
+} CacheHeader;
+
+// Computes a 64-bit FNV-1a hash of the given bytes
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Hashes the whole file in chunks and rewinds it so it can be tokenized afterwards
+uint64_t hash_file(FILE *file)
+{
+    unsigned char buf[4096];
+    size_t n;
+    uint64_t hash = HASH_INIT;
+
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+        hash = hash_bytes(hash, buf, n);
+    }
+    rewind(file);
+    return hash;
+}
+
+// Builds the cache file name by appending 'c' to the source name (myscript.ppp -> myscript.pppc)
+void get_cache_filename(const char *source_file, char *cache_file, size_t size)
+{
+    snprintf(cache_file, size, "%sc", source_file);
+}
+
+// Function to load the token list from the cache file if it matches the current source and interpreter
+int load_program_cache(const char *source_file, uint64_t source_hash)
+{
+    char cache_file[520];
+    get_cache_filename(source_file, cache_file, sizeof(cache_file));
+
+    FILE *file = fopen(cache_file, "rb");
+    if (!file)
+        return 0; // No cache yet
+
+    // The token records fill the rest of the file, which bounds the count before memory is reserved for it
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+
+    CacheHeader header;
+    int valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                memcmp(header.magic, "PPPC", 4) == 0 &&
+                header.version == PPP_VERSION &&
+                header.token_size == sizeof(Token) &&
+                (long)sizeof(header) + (long)header.token_count * (long)sizeof(Token) == file_size &&
+                header.source_hash == source_hash;
+
+    // The token records are stored exactly as they are laid out in memory, so one read restores the program
+    if (valid)
+        reserve_tokens(header.token_count);
+    if (valid && fread(token_list, sizeof(Token), header.token_count, file) == header.token_count)
+    {
+        token_count = header.token_count;
+
+        // The tokens of included modules are part of the program, so an edited module makes the cache stale
+        if (!included_modules_unchanged())
+        {
+            token_count = 0;
+            valid = 0;
+        }
+    }
+    else
+    {
+        valid = 0;
+    }
+
+    fclose(file);
+    return valid;
+}
+
+// Function to store the validated token list so the next run can skip tokenizing and parsing
+void save_program_cache(const char *source_file, uint64_t source_hash)
+{
+    char cache_file[520];
+    char temp_file[530];
+    get_cache_filename(source_file, cache_file, sizeof(cache_file));
+    snprintf(temp_file, sizeof(temp_file), "%s.tmp", cache_file);
+
+    CacheHeader header;
+    memcpy(header.magic, "PPPC", 4);
+    header.version = PPP_VERSION;
+    header.token_size = sizeof(Token);
+    header.token_count = token_count;
+    header.source_hash = source_hash;
+
+    // The cache is only an optimization, so failing to write it is not an error
+    FILE *file = fopen(temp_file, "wb");
+    if (!file)
+        return;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(token_list, sizeof(Token), token_count, file) == (size_t)token_count;
+    ok = (fclose(file) == 0) && ok;
+
+    // Write to a temporary file first and rename it, so a concurrent run never sees a half-written cache
+#ifdef _WIN32
+    remove(cache_file); // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(temp_file, cache_file) != 0)
+    {
+        remove(temp_file);
+    }
+}
+
+// Hashes the types and values of all tokens, together with the interpreter version
+uint64_t hash_token_stream()
+{
+    uint32_t version = PPP_VERSION;
+    uint64_t hash = hash_bytes(HASH_INIT, &version, sizeof(version));
+
+    for (int i = 0; i < token_count; i++)
+    {
+        unsigned char type = (unsigned char)token_list[i].type;
+        hash = hash_bytes(hash, &type, 1);
+        hash = hash_bytes(hash, token_list[i].value, strlen(token_list[i].value) + 1); // Include the terminator to separate values
+    }
+    return hash;
+}
+
+// Paths of the result being captured, kept until it is committed or discarded
+char result_temp_file[600];
+char result_file[600];
+FILE *result_capture = NULL;
+const char *result_dir = NULL;
+
+// Builds the path of a stored result: <dir>/<hash>.out
+void get_result_filename(const char *dir, uint64_t program_hash, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx.out", dir, (unsigned long long)program_hash);
+}
+
+// Function to replay a stored result. The file's modification time is refreshed so eviction is least-recently-used.
+int replay_cached_result(const char *dir, uint64_t program_hash)
+{
+    char path[600];
+    get_result_filename(dir, program_hash, path, sizeof(path));
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    utime(path, NULL); // Mark as recently used
+
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+        output_write(buf, n);
+    }
+    fclose(file);
+    return 1;
+}
+
+// Removes a capture that was never committed (e.g. the program stopped with an error)
+void discard_result_capture()
+{
+    if (!result_capture)
+        return;
+
+    output_set_capture(NULL);
+    fclose(result_capture);
+    result_capture = NULL;
+    remove(result_temp_file);
+}
+
+// Function to start capturing output into <dir>/<hash>.<pid>.tmp
+void begin_result_capture(const char *dir, uint64_t program_hash)
+{
+    // Create the cache directory on first use
+#ifdef _WIN32
+    mkdir(dir);
+#else
+    mkdir(dir, 0777);
+#endif
+
+    get_result_filename(dir, program_hash, result_file, sizeof(result_file));
+    snprintf(result_temp_file, sizeof(result_temp_file), "%s/%016llx.%d.tmp", dir, (unsigned long long)program_hash, (int)getpid());
+
+    // The cache is only an optimization, so the program still runs if the file cannot be created
+    result_capture = fopen(result_temp_file, "wb");
+    if (!result_capture)
+        return;
+
+    result_dir = dir;
+    output_set_capture(result_capture);
+    atexit(discard_result_capture);
+}
+
+// A stored result found while scanning the cache directory
+typedef struct
+{
+    char name[64];
+    long long size;
+    time_t last_used;
+} CachedResult;
+
+// Orders stored results from least to most recently used
+int compare_last_used(const void *a, const void *b)
+{
+    const CachedResult *x = a;
+    const CachedResult *y = b;
+    return (x->last_used > y->last_used) - (x->last_used < y->last_used);
+}
+
+// Deletes the least recently used results until the directory is below the size limit
+void evict_results(const char *dir, long long size_limit)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+
+    CachedResult *results = NULL;
+    int count = 0, capacity = 0;
+    long long total = 0;
+    struct dirent *entry;
+
+    while ((entry = readdir(d)) != NULL)
+    {
+        size_t len = strlen(entry->d_name);
+        if (len < 4 || len >= sizeof(results->name) || strcmp(entry->d_name + len - 4, ".out") != 0)
+            continue; // Not a stored result
+
+        char path[600];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) != 0)
+            continue;
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            results = realloc(results, capacity * sizeof(CachedResult));
+        }
+        strcpy(results[count].name, entry->d_name);
+        results[count].size = st.st_size;
+        results[count].last_used = st.st_mtime;
+        total += st.st_size;
+        count++;
+    }
+    closedir(d);
+
+    qsort(results, count, sizeof(CachedResult), compare_last_used);
+    for (int i = 0; i < count && total > size_limit; i++)
+    {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%s", dir, results[i].name);
+        if (remove(path) == 0)
+            total -= results[i].size;
+    }
+    free(results);
+}
+
+// Function to publish the captured output. The rename makes the result visible atomically to other runs.
+void commit_result_capture(long long size_limit)
+{
+    if (!result_capture)
+        return;
+
+    output_set_capture(NULL);
+    int ok = fclose(result_capture) == 0;
+    result_capture = NULL;
+
+#ifdef _WIN32
+    remove(result_file); // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(result_temp_file, result_file) != 0)
+    {
+        remove(result_temp_file);
+        return;
+    }
+
+    evict_results(result_dir, size_limit);
+}
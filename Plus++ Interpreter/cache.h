@@ -0,0 +1,38 @@
+// cache.h
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Interpreter version stored in every cache file. Bump it whenever the Token layout or the meaning of the token stream changes.
+#define PPP_VERSION 5
+
+// Initial value for hash_bytes (FNV-1a offset basis)
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+// Computes a 64-bit FNV-1a hash of the given bytes, continuing from a previous hash value
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size);
+
+// Computes the hash of the whole contents of an open file and rewinds it
+uint64_t hash_file(FILE *file);
+
+// Loads the compiled program of the given source file from its .pppc cache. Returns 1 if a valid cache was loaded, 0 otherwise.
+int load_program_cache(const char *source_file, uint64_t source_hash);
+
+// Writes the current (already validated) token list to the .pppc cache next to the source file
+void save_program_cache(const char *source_file, uint64_t source_hash);
+
+// Hashes the token stream by token types and values only, so comments, whitespace and line numbers do not change the hash
+uint64_t hash_token_stream();
+
+// Streams the stored output of the program with the given hash to the output. Returns 1 on a cache hit, 0 otherwise.
+int replay_cached_result(const char *dir, uint64_t program_hash);
+
+// Starts copying the program output into a temporary file of the result cache
+void begin_result_capture(const char *dir, uint64_t program_hash);
+
+// Stores the captured output under the program hash and evicts least recently used results above the size limit
+void commit_result_capture(long long size_limit);
+
+#endif
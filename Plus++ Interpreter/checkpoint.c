@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+#include "checkpoint.h"
+#include "interpreter.h"
+#include "cache.h"
+#include "options.h"
+#include "output.h"
+#include "input.h"
+
+// Header of a checkpoint file. It is followed by frame_depth Frame records and var_count SavedVariable records.
+typedef struct
+{
+    char magic[4];         // Always "PPPS"
+    uint32_t version;      // PPP_VERSION of the interpreter that wrote the file
+    uint64_t program_hash; // hash_token_stream() of the program the state belongs to
+    int32_t current;       // Token position of the next statement
+    int32_t frame_depth;   // Number of open blocks and loops
+    int32_t var_count;     // Number of declared variables
+    int32_t reserved;
+    int64_t output_bytes;  // Program output produced before the checkpoint
+    int64_t stdout_offset; // Position in stdout where the next output byte goes, -1 if stdout is not a file
+    int64_t input_bytes;   // Input consumed by read statements before the checkpoint
+} CheckpointHeader;
+
+// A variable in a checkpoint file, followed by the limbs of its value
+typedef struct
+{
+    char name[64];
+    int32_t initialized;
+    int32_t negative;
+    int32_t length; // Number of limbs that follow
+    int32_t reserved;
+} SavedVariable;
+
+// Time at which the next checkpoint is due (0 until the first poll)
+time_t next_checkpoint = 0;
+
+#ifndef _WIN32
+// Child process that is still writing the previous checkpoint, 0 if none
+pid_t checkpoint_writer = 0;
+#endif
+
+// Function to write the variables with their values
+int write_variables(FILE *file)
+{
+    for (int i = 0; i < var_count; i++)
+    {
+        const BigInt *value = variable_value(i);
+        SavedVariable saved;
+        memset(&saved, 0, sizeof(saved));
+        strcpy(saved.name, var_table[i].name);
+        saved.initialized = var_table[i].initialized;
+        saved.negative = value->negative;
+        saved.length = value->length;
+
+        if (fwrite(&saved, sizeof(saved), 1, file) != 1 ||
+            fwrite(value->limbs, sizeof(uint32_t), saved.length, file) != (size_t)saved.length)
+            return 0;
+    }
+    return 1;
+}
+
+// Function to read the variables written by write_variables(). Returns 0 if the file is truncated or corrupted.
+int read_variables(FILE *file, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        SavedVariable saved;
+        if (fread(&saved, sizeof(saved), 1, file) != 1 || saved.length < 0 || saved.length > BIGINT_MAX_LIMBS ||
+            memchr(saved.name, '\0', sizeof(saved.name)) == NULL)
+            return 0;
+
+        Variable *v = &var_table[i];
+        strcpy(v->name, saved.name);
+        v->initialized = saved.initialized;
+        bigint_settle(&v->value, &v->carries); // Drop carries a previous value may have left pending
+        bigint_reserve(&v->value, saved.length);
+        if (fread(v->value.limbs, sizeof(uint32_t), saved.length, file) != (size_t)saved.length)
+            return 0;
+        v->value.length = saved.length;
+        v->value.negative = saved.negative != 0;
+    }
+    return 1;
+}
+
+// Function to write the execution state to a temporary file and rename it over the checkpoint file
+void write_checkpoint(const char *filename, const CheckpointHeader *header)
+{
+    char temp_file[600];
+    snprintf(temp_file, sizeof(temp_file), "%s.tmp", filename);
+
+    FILE *file = fopen(temp_file, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "[WARNING]: Could not write checkpoint '%s'.\n", temp_file);
+        return;
+    }
+
+    int ok = fwrite(header, sizeof(*header), 1, file) == 1 &&
+             fwrite(frame_stack, sizeof(Frame), frame_depth, file) == (size_t)frame_depth &&
+             write_variables(file);
+    ok = (fclose(file) == 0) && ok;
+
+#ifdef _WIN32
+    remove(filename); // rename() does not replace existing files on Windows
+#endif
+    if (!ok || rename(temp_file, filename) != 0)
+    {
+        fprintf(stderr, "[WARNING]: Could not write checkpoint '%s'.\n", filename);
+        remove(temp_file);
+    }
+}
+
+// Function to take a checkpoint once the interval has passed
+void poll_checkpoint()
+{
+    time_t now = time(NULL);
+
+    if (next_checkpoint == 0)
+    {
+        next_checkpoint = now + options.checkpoint_interval;
+        return;
+    }
+    if (now < next_checkpoint)
+        return;
+
+#ifndef _WIN32
+    // Do not start a new checkpoint while the previous one is still being written
+    if (checkpoint_writer > 0)
+    {
+        if (waitpid(checkpoint_writer, NULL, WNOHANG) == 0)
+            return;
+        checkpoint_writer = 0;
+    }
+#endif
+    next_checkpoint = now + options.checkpoint_interval;
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PPPS", 4);
+    header.version = PPP_VERSION;
+    header.program_hash = hash_token_stream();
+    header.current = current;
+    header.frame_depth = frame_depth;
+    header.var_count = var_count;
+    header.output_bytes = output_bytes;
+    header.input_bytes = input_bytes;
+
+    // Everything written before the checkpoint must survive a crash, so flush it before recording the position
+    output_flush();
+    fflush(stdout);
+    header.stdout_offset = ftell(stdout);
+
+#ifdef _WIN32
+    write_checkpoint(options.checkpoint_file, &header);
+#else
+    // The child process gets a copy-on-write view of the state, so the interpreter keeps running while it is saved
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        write_checkpoint(options.checkpoint_file, &header);
+        _exit(0); // Skip atexit handlers, the parent still owns the output
+    }
+    if (pid > 0)
+    {
+        checkpoint_writer = pid;
+    }
+    else
+    {
+        write_checkpoint(options.checkpoint_file, &header); // fork() failed, write it ourselves
+    }
+#endif
+}
+
+// Function to stop with an error about an unusable checkpoint file
+void checkpoint_error(const char *filename, const char *reason)
+{
+    fprintf(stderr, "[ERROR]: Cannot resume from checkpoint '%s': %s.\n", filename, reason);
+    exit(1);
+}
+
+// Function to load the execution state from a checkpoint file written by poll_checkpoint()
+void load_checkpoint(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        checkpoint_error(filename, "file cannot be opened");
+
+    CheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "PPPS", 4) != 0)
+        checkpoint_error(filename, "not a checkpoint file");
+    if (header.version != PPP_VERSION)
+        checkpoint_error(filename, "written by a different interpreter version");
+    if (header.program_hash != hash_token_stream())
+        checkpoint_error(filename, "written for a different program");
+    if (header.current < 0 || header.current > token_count ||
+        header.frame_depth < 0 || header.frame_depth > token_count ||
+        header.var_count < 0 || header.var_count > MAX_VARS)
+        checkpoint_error(filename, "file is corrupted");
+
+    reserve_frames(header.frame_depth);
+    if (fread(frame_stack, sizeof(Frame), header.frame_depth, file) != (size_t)header.frame_depth ||
+        !read_variables(file, header.var_count))
+        checkpoint_error(filename, "file is truncated");
+    fclose(file);
+
+    current = header.current;
+    frame_depth = header.frame_depth;
+    var_count = header.var_count;
+    output_bytes = header.output_bytes;
+
+    // Read statements continue with the first number after the ones read before the checkpoint
+    if (header.input_bytes > 0 && !input_skip(header.input_bytes))
+        checkpoint_error(filename, "the input is shorter than when the checkpoint was taken");
+
+    // If the output goes to the same file as before (e.g. appended with >>), drop whatever was written
+    // after the checkpoint, so the resumed run continues exactly where the saved state left off
+    struct stat st;
+    fflush(stdout);
+    if (header.stdout_offset >= 0 && fstat(fileno(stdout), &st) == 0 &&
+        S_ISREG(st.st_mode) && st.st_size >= header.stdout_offset)
+    {
+        if (ftruncate(fileno(stdout), header.stdout_offset) == 0)
+        {
+            fseek(stdout, header.stdout_offset, SEEK_SET);
+        }
+    }
+}
+
+// Function to clean up after a completed run
+void finish_checkpoints()
+{
+#ifndef _WIN32
+    if (checkpoint_writer > 0)
+    {
+        waitpid(checkpoint_writer, NULL, 0);
+        checkpoint_writer = 0;
+    }
+#endif
+    remove(options.checkpoint_file);
+}
@@ -0,0 +1,17 @@
+// checkpoint.h
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Number of statements executed between two checks of the checkpoint timer
+#define CHECKPOINT_POLL_INTERVAL 4096
+
+// Writes a checkpoint of the execution state if the checkpoint interval has passed
+void poll_checkpoint();
+
+// Restores the execution state saved in a checkpoint file. The program itself must already be loaded.
+void load_checkpoint(const char *filename);
+
+// Removes the checkpoint file after the program has finished, so a completed run is not resumed
+void finish_checkpoints();
+
+#endif
@@ -0,0 +1,780 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "compiler.h"
+#include "interpreter.h"
+#include "output.h"
+#include "input.h"
+#include "metrics.h"
+#include "status.h"
+
+// Compiled bodies are also translated into x86-64 machine code: a call per instruction with the jumps of the loops
+// between them, and small additions done inline. Windows passes arguments in other registers, so it keeps running the
+// instruction list.
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(PPP_NO_NATIVE)
+#define COMPILER_NATIVE
+#include <sys/mman.h>
+
+void compile_native(CompiledBody *body);
+#endif
+
+// Instructions of the body being compiled
+Instruction *code = NULL;
+int code_length = 0;
+int code_capacity = 0;
+
+// Current and deepest nesting of repeat loops inside the body being compiled
+int loop_depth = 0;
+int max_loop_depth = 0;
+
+// Statements compiled since the last instruction was emitted; they start with the next one
+int pending_statements = 0;
+
+// Source line of the statement being compiled
+int compile_line = 0;
+
+// Constant pool of the body being compiled
+char *pool = NULL;
+int pool_length = 0;
+int pool_capacity = 0;
+
+// An open block or repeat loop of the statement being compiled
+typedef struct
+{
+    int repeat; // Index of the OP_REPEAT of a loop, -1 for a block
+    int end;    // Token index where it ends: the '}' of a block, or just past the body of a loop
+    int line;   // Line of the repeat statement
+} CompileFrame;
+
+// Stack of the blocks and loops that are open while a statement is compiled, so nesting does not use the C stack
+CompileFrame *compile_frames = NULL;
+int compile_frame_capacity = 0;
+
+// Function to append an instruction and return its index (indices stay valid when the list grows)
+int emit(OpCode op)
+{
+    if (code_length == code_capacity)
+    {
+        code_capacity = code_capacity ? code_capacity * 2 : 32;
+        code = realloc(code, code_capacity * sizeof(Instruction));
+    }
+    Instruction *in = &code[code_length];
+    memset(in, 0, sizeof(*in));
+    in->op = op;
+    in->slot = -1;
+    in->operand_slot = -1;
+    in->line = compile_line;
+    in->statements = pending_statements;
+    pending_statements = 0;
+    return code_length++;
+}
+
+// Function to set the operand of an instruction from a constant or variable token. Returns 0 if it cannot be resolved.
+int set_operand(int index, Token *t)
+{
+    if (t->type == TOKEN_INTCONST)
+    {
+        bigint_parse(&code[index].constant, t->value);
+        return 1;
+    }
+    if (t->type == TOKEN_IDENTIFIER)
+    {
+        code[index].operand_slot = find_var(t->value);
+        return code[index].operand_slot != -1;
+    }
+    return 0;
+}
+
+// Function to add the output of a constant write item to the constant pool. Consecutive constant items, also those of
+// consecutive write statements, become one OP_WRITE_STRING, so they are written with a single copy. Only loop
+// instructions separate them, since a jump may land between them.
+void emit_text(const char *text, int size)
+{
+    if (code_length == 0 || code[code_length - 1].op != OP_WRITE_STRING)
+    {
+        int index = emit(OP_WRITE_STRING);
+        code[index].offset = pool_length;
+    }
+
+    if (pool_length + size > pool_capacity)
+    {
+        pool_capacity = (pool_length + size) * 2;
+        pool = realloc(pool, pool_capacity);
+    }
+    memcpy(pool + pool_length, text, size);
+    pool_length += size;
+    code[code_length - 1].size += size;
+}
+
+// Function to free a list of instructions and their constants
+void free_code(Instruction *code, int length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        bigint_free(&code[i].constant);
+    }
+    free(code);
+}
+
+// Function to open a block or loop while compiling a statement
+void push_compile_frame(int depth, int repeat, int end, int line)
+{
+    if (depth == compile_frame_capacity)
+    {
+        compile_frame_capacity = compile_frame_capacity ? compile_frame_capacity * 2 : 16;
+        compile_frames = realloc(compile_frames, compile_frame_capacity * sizeof(CompileFrame));
+    }
+    compile_frames[depth].repeat = repeat;
+    compile_frames[depth].end = end;
+    compile_frames[depth].line = line;
+}
+
+// Function to compile the statement starting at token i. Returns the index just past it, or -1 if it is not supported.
+int compile_statement(int i)
+{
+    int depth = 0; // Blocks and loops opened by this statement and not closed yet
+
+    do
+    {
+        Token *t = &token_list[i];
+        pending_statements++;
+        compile_line = t->line;
+
+        // Block: its statements are compiled one after another until the '}'
+        if (t->type == TOKEN_OPENBLOCK)
+        {
+            push_compile_frame(depth++, -1, statement_end(i) - 1, t->line);
+            i++;
+        }
+
+        // Write statement: one instruction per item
+        else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "write") == 0)
+        {
+            for (i++; token_list[i].type != TOKEN_ENDOFLINE; i++)
+            {
+                Token *item = &token_list[i];
+                if (item->type == TOKEN_KEYWORD && strcmp(item->value, "and") == 0)
+                    continue;
+
+                // Strings, newlines and constants are written as they are rendered now
+                if (item->type == TOKEN_STRINGCONST)
+                {
+                    emit_text(item->value, strlen(item->value));
+                }
+                else if (item->type == TOKEN_KEYWORD && strcmp(item->value, "newline") == 0)
+                {
+                    emit_text("\n", 1);
+                }
+                else if (item->type == TOKEN_INTCONST)
+                {
+                    BigInt constant = {0};
+                    bigint_parse(&constant, item->value);
+                    char *text = malloc(bigint_decimal_size(&constant));
+                    emit_text(text, bigint_to_decimal(&constant, text));
+                    free(text);
+                    bigint_free(&constant);
+                }
+                else if (!set_operand(emit(OP_WRITE_VALUE), item))
+                {
+                    return -1;
+                }
+            }
+            i++; // Skip the semicolon
+        }
+
+        // Read statement: read <identifier>;
+        else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "read") == 0)
+        {
+            int index = emit(OP_READ);
+            code[index].line = token_list[i + 1].line;
+            code[index].slot = find_var(token_list[i + 1].value);
+            if (code[index].slot == -1)
+                return -1;
+            i += 3; // Skip the semicolon
+        }
+
+        // Nested repeat loop: repeat <count> times <statement>; the body follows and OP_END_REPEAT is emitted at its end
+        else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "repeat") == 0)
+        {
+            Token *count_tok = &token_list[i + 1];
+            int start = emit(OP_REPEAT);
+            if (!set_operand(start, count_tok))
+                return -1;
+            code[start].slot = count_tok->type == TOKEN_IDENTIFIER ? code[start].operand_slot : -1;
+
+            if (++loop_depth > MAX_COMPILED_LOOP_DEPTH)
+                return -1;
+            if (loop_depth > max_loop_depth)
+                max_loop_depth = loop_depth;
+            push_compile_frame(depth++, start, statement_end(i + 3), t->line);
+            i += 3; // Skip "repeat <count> times"
+        }
+
+        // Assignment, increment or decrement: <identifier> <operator> <value>;
+        else if (t->type == TOKEN_IDENTIFIER)
+        {
+            Token *op = &token_list[i + 1];
+            OpCode opcode;
+            if (strcmp(op->value, ":=") == 0)
+                opcode = OP_ASSIGN;
+            else if (strcmp(op->value, "+=") == 0)
+                opcode = OP_ADD;
+            else if (strcmp(op->value, "-=") == 0)
+                opcode = OP_SUB;
+            else if (strcmp(op->value, "*=") == 0)
+                opcode = OP_MUL;
+            else if (strcmp(op->value, "/=") == 0)
+                opcode = OP_DIV;
+            else if (strcmp(op->value, "%=") == 0)
+                opcode = OP_MOD;
+            else if (strcmp(op->value, "^=") == 0)
+                opcode = OP_POW;
+            else
+                return -1;
+
+            int index = emit(opcode);
+            code[index].line = op->line;
+            code[index].slot = find_var(t->value);
+            if (code[index].slot == -1 || !set_operand(index, &token_list[i + 2]))
+                return -1;
+            i += 4; // Skip the semicolon
+        }
+
+        // Anything else (declarations in particular) stays in the interpreter
+        else
+        {
+            return -1;
+        }
+
+        // Close the blocks and loops that end here
+        while (depth > 0 && i == compile_frames[depth - 1].end)
+        {
+            const CompileFrame *f = &compile_frames[--depth];
+            if (f->repeat < 0)
+            {
+                i++; // Skip the '}'
+                continue;
+            }
+
+            int end = emit(OP_END_REPEAT);
+            code[end].line = f->line;
+            code[end].slot = code[f->repeat].slot;
+            code[end].jump = f->repeat;
+            code[f->repeat].jump = end;
+            loop_depth--;
+        }
+    } while (depth > 0);
+
+    return i;
+}
+
+// Function to compile a loop body into a flat instruction list
+CompiledBody *compile_body(int start, int end)
+{
+    code = NULL;
+    code_length = 0;
+    code_capacity = 0;
+    pool = NULL;
+    pool_length = 0;
+    pool_capacity = 0;
+    loop_depth = 0;
+    max_loop_depth = 0;
+    pending_statements = 0;
+
+    if (compile_statement(start) != end)
+    {
+        free_code(code, code_length);
+        free(pool);
+        return NULL;
+    }
+
+    CompiledBody *body = malloc(sizeof(CompiledBody));
+    body->code = code;
+    body->length = code_length;
+    body->pool = pool;
+    body->loops = malloc((max_loop_depth + 1) * sizeof(long long));
+    body->statements = pending_statements;
+    body->native = NULL;
+    body->native_size = 0;
+#ifdef COMPILER_NATIVE
+    compile_native(body);
+#endif
+    return body;
+}
+
+// Function to get the value of the variable in a slot. Checking for pending carries here keeps the common case
+// free of calls in the compiled loop.
+BigInt *slot_value(int slot)
+{
+    return var_table[slot].carries.pending ? variable_value(slot) : &var_table[slot].value;
+}
+
+// Function to add an operand to the variable in a slot (subtract it if negate is set)
+void slot_add(int slot, const BigInt *value, int negate)
+{
+    if (var_table[slot].carries.pending || value->length >= CARRY_SAVE_MIN_LIMBS)
+        accumulate(slot, value, negate);
+    else if (negate)
+        bigint_sub(&var_table[slot].value, value);
+    else
+        bigint_add(&var_table[slot].value, value);
+}
+
+// Function to get the value of an instruction's operand
+const BigInt *operand_value(const Instruction *in)
+{
+    return in->operand_slot >= 0 ? slot_value(in->operand_slot) : &in->constant;
+}
+
+#ifdef COMPILER_NATIVE
+// Counters of the body that runs as machine code. Its instructions are separate calls, so they cannot be kept in
+// locals as in run_compiled(); the machine code keeps their address in rbx.
+typedef struct
+{
+    long long statements;
+    long long operations;
+    long long wide_operations;
+} NativeCounters;
+
+NativeCounters native_counters;
+
+// Body that runs as machine code, and the number of its loops that are running
+const CompiledBody *native_body = NULL;
+int native_depth = 0;
+
+// Function to count the statements of an instruction, and the operation of an arithmetic one
+void native_count(const Instruction *in)
+{
+    native_counters.statements += in->statements;
+    if (in->op <= OP_POW)
+    {
+        int target = var_table[in->slot].value.length;
+        int operand = in->operand_slot >= 0 ? var_table[in->operand_slot].value.length : in->constant.length;
+        native_counters.operations++;
+        if (target > 2 || operand > 2)
+        {
+            COUNT_BIGINT_OPERATION(target, operand);
+            native_counters.wide_operations++;
+        }
+    }
+}
+
+// Functions the machine code calls for each instruction. OP_REPEAT returns 1 to enter the body and OP_END_REPEAT 1 to
+// run it again; the others return 0.
+int native_assign(const Instruction *in)
+{
+    native_count(in);
+    bigint_copy(slot_value(in->slot), operand_value(in));
+    return 0;
+}
+
+int native_add(const Instruction *in)
+{
+    native_count(in);
+    slot_add(in->slot, operand_value(in), 0);
+    return 0;
+}
+
+int native_sub(const Instruction *in)
+{
+    native_count(in);
+    slot_add(in->slot, operand_value(in), 1);
+    return 0;
+}
+
+int native_mul(const Instruction *in)
+{
+    native_count(in);
+    bigint_mul(slot_value(in->slot), operand_value(in));
+    return 0;
+}
+
+int native_div(const Instruction *in)
+{
+    native_count(in);
+    check_arithmetic(bigint_div(slot_value(in->slot), operand_value(in)), in->line);
+    return 0;
+}
+
+int native_mod(const Instruction *in)
+{
+    native_count(in);
+    check_arithmetic(bigint_mod(slot_value(in->slot), operand_value(in)), in->line);
+    return 0;
+}
+
+int native_pow(const Instruction *in)
+{
+    native_count(in);
+    check_arithmetic(bigint_pow(slot_value(in->slot), operand_value(in)), in->line);
+    return 0;
+}
+
+int native_write_string(const Instruction *in)
+{
+    native_count(in);
+    output_write(native_body->pool + in->offset, in->size);
+    return 0;
+}
+
+int native_write_value(const Instruction *in)
+{
+    native_count(in);
+    output_bigint(operand_value(in));
+    return 0;
+}
+
+int native_read(const Instruction *in)
+{
+    native_count(in);
+    check_input(input_read(slot_value(in->slot)), in->line);
+    return 0;
+}
+
+int native_repeat(const Instruction *in)
+{
+    native_count(in);
+    long long count = bigint_clamp(operand_value(in));
+    if (count >= 1)
+    {
+        native_body->loops[native_depth++] = count;
+        return 1;
+    }
+    if (in->slot >= 0)
+        bigint_set_ll(slot_value(in->slot), 0);
+    return 0;
+}
+
+int native_end_repeat(const Instruction *in)
+{
+    native_count(in);
+    if (status_requested)
+        report_status(native_body, (int)(in - native_body->code), native_depth, native_counters.statements);
+    long long remaining = --native_body->loops[native_depth - 1];
+    loop_iterations++;
+    if (in->slot >= 0)
+        bigint_set_ll(slot_value(in->slot), remaining);
+    if (remaining >= 1)
+        return 1;
+    native_depth--;
+    return 0;
+}
+
+typedef int (*NativeHandler)(const Instruction *in);
+
+// Handler of each operation
+NativeHandler native_handlers[] = {
+    [OP_ASSIGN] = native_assign,
+    [OP_ADD] = native_add,
+    [OP_SUB] = native_sub,
+    [OP_MUL] = native_mul,
+    [OP_DIV] = native_div,
+    [OP_MOD] = native_mod,
+    [OP_POW] = native_pow,
+    [OP_WRITE_STRING] = native_write_string,
+    [OP_WRITE_VALUE] = native_write_value,
+    [OP_READ] = native_read,
+    [OP_REPEAT] = native_repeat,
+    [OP_END_REPEAT] = native_end_repeat,
+};
+
+// Machine code being generated. The code is generated twice: first only to measure it (native_text is NULL), then
+// into memory of that size.
+unsigned char *native_text = NULL;
+size_t native_length = 0;
+
+// Function to append bytes to the machine code
+void put_code(const void *bytes, int n)
+{
+    if (native_text)
+        memcpy(native_text + native_length, bytes, n);
+    native_length += n;
+}
+
+// Function to set the 32-bit displacement at a position of the machine code, so the jump it ends lands on target
+void set_jump(size_t at, size_t target)
+{
+    int displacement = (int)target - (int)(at + 4);
+    if (native_text)
+        memcpy(native_text + at, &displacement, 4);
+}
+
+// Function to append a conditional jump (0x0F and the opcode), returning the position of its displacement
+size_t put_jump(unsigned char opcode)
+{
+    unsigned char bytes[6] = {0x0F, opcode, 0, 0, 0, 0};
+    put_code(bytes, 6);
+    return native_length - 4;
+}
+
+// Function to append a compare of a 32-bit field of a variable (its address in rax) with a small value, and a jump
+// taken if they differ. Returns the position of the jump's displacement.
+size_t put_field_check(size_t field, int value)
+{
+    int displacement = (int)field;
+    unsigned char value8 = (unsigned char)value;
+    put_code("\x83\xB8", 2); // cmp dword [rax + disp32], imm8
+    put_code(&displacement, 4);
+    put_code(&value8, 1);
+    return put_jump(0x85); // jne
+}
+
+// Function to append the code that loads the address of a variable's limbs into rdx, if the variable holds one limb,
+// is not negative and has no pending carries. Otherwise it jumps; the positions of the jumps are added to to_call.
+void put_small_variable(int slot, size_t *to_call, int *jumps)
+{
+    const Variable *v = &var_table[slot];
+    int limbs = (int)offsetof(Variable, value.limbs);
+    put_code("\x48\xB8", 2); // mov rax, imm64: the variable
+    put_code(&v, 8);
+    to_call[(*jumps)++] = put_field_check(offsetof(Variable, carries.pending), 0);
+    to_call[(*jumps)++] = put_field_check(offsetof(Variable, value.negative), 0);
+    to_call[(*jumps)++] = put_field_check(offsetof(Variable, value.length), 1);
+    put_code("\x48\x8B\x90", 3); // mov rdx, [rax + disp32]
+    put_code(&limbs, 4);
+}
+
+// Function to append the inline code of += and -= with an operand of one limb. If the target and a variable operand
+// both hold one limb that is not negative and have no pending carries, the target is changed in place, as long as
+// the result is still one nonzero limb. Anything else jumps to the call of the handler, which the caller appends
+// next; the positions of those jumps go to to_call. Returns the position of the displacement of the jump past the
+// call.
+size_t put_inline_add(const Instruction *in, size_t *to_call, int *jumps)
+{
+    int subtract = in->op == OP_SUB;
+    if (in->operand_slot >= 0)
+    {
+        put_small_variable(in->operand_slot, to_call, jumps);
+        put_code("\x8B\x32", 2); // mov esi, [rdx]
+    }
+    else
+    {
+        uint32_t constant = in->constant.length ? in->constant.limbs[0] : 0;
+        subtract = subtract != in->constant.negative;
+        put_code("\xBE", 1); // mov esi, imm32
+        put_code(&constant, 4);
+    }
+
+    put_small_variable(in->slot, to_call, jumps);
+    put_code("\x8B\x0A", 2);                             // mov ecx, [rdx]
+    put_code(subtract ? "\x29\xF1" : "\x01\xF1", 2);     // sub ecx, esi / add ecx, esi
+    to_call[(*jumps)++] = put_jump(subtract ? 0x86 : 0x82); // jbe: borrow or zero / jc: carry
+    put_code("\x89\x0A", 2);                             // mov [rdx], ecx
+
+    // The counting of native_count(): statements, and an operation that is never wide
+    put_code("\x48\xFF\x43\x08", 4); // inc qword [rbx + 8]
+    if (in->statements)
+    {
+        int statements = in->statements;
+        put_code("\x48\x81\x03", 3); // add qword [rbx], imm32
+        put_code(&statements, 4);
+    }
+    put_code("\xE9\0\0\0\0", 5); // jmp rel32
+    return native_length - 4;
+}
+
+// Function to generate the machine code of a body. start receives where the code of each instruction starts, and
+// of the return after the last one; the jumps of the loops use the positions of the previous pass.
+void generate_native(const CompiledBody *body, int *start)
+{
+    native_length = 0;
+    const NativeCounters *counters = &native_counters;
+    put_code("\x53", 1); // push rbx: saved for the caller, and keeps the stack 16-byte aligned for the calls
+    put_code("\x48\xBB", 2); // mov rbx, imm64: the counters
+    put_code(&counters, 8);
+
+    for (int i = 0; i < body->length; i++)
+    {
+        const Instruction *in = &body->code[i];
+        start[i] = (int)native_length;
+
+        size_t to_call[8], past_call = 0;
+        int jumps = 0;
+        int inline_add = (in->op == OP_ADD || in->op == OP_SUB) && (in->operand_slot >= 0 || in->constant.length <= 1);
+        if (inline_add)
+            past_call = put_inline_add(in, to_call, &jumps);
+        for (int j = 0; j < jumps; j++)
+            set_jump(to_call[j], native_length);
+
+        NativeHandler handler = native_handlers[in->op];
+        put_code("\x48\xBF", 2); // mov rdi, imm64: the instruction is the handler's argument
+        put_code(&in, 8);
+        put_code("\x48\xB8", 2); // mov rax, imm64
+        put_code(&handler, 8);
+        put_code("\xFF\xD0", 2); // call rax
+        if (inline_add)
+            set_jump(past_call, native_length);
+
+        // Both jumps land on the instruction after the one the loop instruction is paired with: OP_REPEAT jumps past
+        // its OP_END_REPEAT when the body is skipped, OP_END_REPEAT to the start of the body for the next iteration
+        if (in->op == OP_REPEAT || in->op == OP_END_REPEAT)
+        {
+            put_code("\x85\xC0", 2); // test eax, eax
+            size_t at = put_jump(in->op == OP_REPEAT ? 0x84 : 0x85); // jz / jnz
+            set_jump(at, start[in->jump + 1]);
+        }
+    }
+    start[body->length] = (int)native_length;
+    put_code("\x5B\xC3", 2); // pop rbx; ret
+}
+
+// Function to translate the instructions of a body into machine code. The code is written while the memory is
+// writable and only then made executable. Leaves body->native NULL if that fails.
+void compile_native(CompiledBody *body)
+{
+    int *start = calloc(body->length + 1, sizeof(int));
+    native_text = NULL;
+    generate_native(body, start);
+    size_t size = native_length;
+
+    unsigned char *text = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (text != MAP_FAILED)
+    {
+        native_text = text;
+        generate_native(body, start);
+        native_text = NULL;
+        if (mprotect(text, size, PROT_READ | PROT_EXEC) == 0)
+        {
+            body->native = text;
+            body->native_size = size;
+        }
+        else
+        {
+            munmap(text, size);
+        }
+    }
+    free(start);
+}
+
+// Function to run one iteration of a body as machine code
+void run_native(const CompiledBody *body)
+{
+    native_body = body;
+    native_depth = 0;
+    native_counters.statements = body->statements;
+    native_counters.operations = 0;
+    native_counters.wide_operations = 0;
+
+    ((void (*)(void))(void *)body->native)();
+
+    statements_executed += native_counters.statements;
+    bigint_operations[0] += native_counters.operations - native_counters.wide_operations;
+}
+#endif
+
+// Function to run one iteration of a compiled body. Loops follow the same rules as in the interpreter:
+// the count is read once, and a count variable always holds the number of iterations left.
+void run_compiled(const CompiledBody *body)
+{
+    const Instruction *code = body->code;
+    long long *loops = body->loops;
+    int depth = 0;
+    long long statements = body->statements;
+    long long operations = 0, wide_operations = 0;
+
+#ifdef COMPILER_NATIVE
+    if (body->native)
+    {
+        run_native(body);
+        return;
+    }
+#endif
+
+    for (int pc = 0; pc < body->length; pc++)
+    {
+        const Instruction *in = &code[pc];
+        statements += in->statements;
+        if (in->op <= OP_POW)
+        {
+            // Operations on single-word numbers are only counted in a register; longer ones go to their bucket
+            int target = var_table[in->slot].value.length;
+            int operand = in->operand_slot >= 0 ? var_table[in->operand_slot].value.length : in->constant.length;
+            operations++;
+            if (target > 2 || operand > 2)
+            {
+                COUNT_BIGINT_OPERATION(target, operand);
+                wide_operations++;
+            }
+        }
+        switch (in->op)
+        {
+        case OP_ASSIGN:
+            bigint_copy(slot_value(in->slot), operand_value(in));
+            break;
+        case OP_ADD:
+            slot_add(in->slot, operand_value(in), 0);
+            break;
+        case OP_SUB:
+            slot_add(in->slot, operand_value(in), 1);
+            break;
+        case OP_MUL:
+            bigint_mul(slot_value(in->slot), operand_value(in));
+            break;
+        case OP_DIV:
+            check_arithmetic(bigint_div(slot_value(in->slot), operand_value(in)), in->line);
+            break;
+        case OP_MOD:
+            check_arithmetic(bigint_mod(slot_value(in->slot), operand_value(in)), in->line);
+            break;
+        case OP_POW:
+            check_arithmetic(bigint_pow(slot_value(in->slot), operand_value(in)), in->line);
+            break;
+        case OP_WRITE_STRING:
+            output_write(body->pool + in->offset, in->size);
+            break;
+        case OP_WRITE_VALUE:
+            output_bigint(operand_value(in));
+            break;
+        case OP_READ:
+            check_input(input_read(slot_value(in->slot)), in->line);
+            break;
+        case OP_REPEAT:
+        {
+            long long count = bigint_clamp(operand_value(in));
+            if (count >= 1)
+            {
+                loops[depth++] = count;
+            }
+            else
+            {
+                if (in->slot >= 0)
+                    bigint_set_ll(slot_value(in->slot), 0);
+                pc = in->jump; // Skip the body
+            }
+            break;
+        }
+        case OP_END_REPEAT:
+        {
+            if (status_requested)
+                report_status(body, pc, depth, statements);
+            long long remaining = --loops[depth - 1];
+            loop_iterations++;
+            if (in->slot >= 0)
+                bigint_set_ll(slot_value(in->slot), remaining);
+            if (remaining >= 1)
+                pc = in->jump; // Next iteration starts after the OP_REPEAT
+            else
+                depth--;
+            break;
+        }
+        }
+    }
+    statements_executed += statements;
+    bigint_operations[0] += operations - wide_operations;
+}
+
+// Function to free a compiled body
+void free_compiled(CompiledBody *body)
+{
+    if (!body)
+        return;
+#ifdef COMPILER_NATIVE
+    if (body->native)
+        munmap(body->native, body->native_size);
+#endif
+    free_code(body->code, body->length);
+    free(body->pool);
+    free(body->loops);
+    free(body);
+}
@@ -0,0 +1,68 @@
+// compiler.h
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "bigint.h"
+
+// Default number of iterations after which a repeat body is compiled
+#define DEFAULT_COMPILE_THRESHOLD 16
+
+// Bodies with loops nested deeper than this stay in the interpreter. Every hot body of a deep nest would otherwise get
+// its own copy of all the loops inside it, which takes quadratic time and memory in the nesting depth.
+#define MAX_COMPILED_LOOP_DEPTH 64
+
+// Operations of compiled code
+typedef enum
+{
+    OP_ASSIGN,       // var := operand
+    OP_ADD,          // var += operand
+    OP_SUB,          // var -= operand
+    OP_MUL,          // var *= operand
+    OP_DIV,          // var /= operand
+    OP_MOD,          // var %= operand
+    OP_POW,          // var ^= operand
+    OP_WRITE_STRING, // write bytes of the constant pool: strings, newlines and constants rendered at compile time
+    OP_WRITE_VALUE,  // write the value of the operand
+    OP_READ,         // read the next number of the input into var
+    OP_REPEAT,       // start of a nested repeat loop; jumps past its OP_END_REPEAT if the count is below 1
+    OP_END_REPEAT    // end of a nested repeat body; jumps back to the start of the body while iterations are left
+} OpCode;
+
+// A single compiled instruction. Variables are resolved to var_table slots and constants are already converted.
+typedef struct
+{
+    OpCode op;
+    int slot;           // Target variable (OP_ASSIGN to OP_POW, OP_READ) or count variable of a loop (-1 for a constant count)
+    int operand_slot;   // Variable used as the operand, -1 if the operand is the constant
+    BigInt constant;    // Constant operand
+    int offset, size;   // Bytes of the constant pool written by OP_WRITE_STRING
+    int jump;           // OP_REPEAT: index of its OP_END_REPEAT; OP_END_REPEAT: index of its OP_REPEAT
+    int line;           // Source line, for runtime errors and status reports
+    int statements;     // Statements of the source that start with this instruction, for the metrics
+} Instruction;
+
+// A compiled repeat body
+typedef struct
+{
+    Instruction *code;
+    int length;
+    char *pool;            // Constant pool: the output of constant write items, rendered when the body was compiled
+    long long *loops;      // Remaining iterations of the nested loops while the body runs
+    int statements;        // Statements after the last instruction (empty blocks), for the metrics
+    unsigned char *native; // Machine code that runs the instructions, NULL where the instruction list is run
+    size_t native_size;    // Bytes mapped for the machine code
+} CompiledBody;
+
+// Compiles the statement in tokens [start, end) (a loop body). Returns NULL if it contains anything the
+// compiled code does not support (e.g. declarations), in which case it keeps running in the interpreter.
+// On x86-64 (except Windows, and unless built with PPP_NO_NATIVE) the instructions are also translated into
+// machine code; if no executable memory can be had, the instruction list is run instead.
+CompiledBody *compile_body(int start, int end);
+
+// Runs one iteration of a compiled body
+void run_compiled(const CompiledBody *body);
+
+// Frees a compiled body
+void free_compiled(CompiledBody *body);
+
+#endif
@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "emit_c.h"
+#include "lexer.h"
+#include "interpreter.h"
+
+// Deepest indentation written; deeper code is not indented further, so the output of deeply nested programs stays linear
+#define MAX_C_INDENT 32
+
+// File receiving the generated code and the current indentation level
+FILE *c_out;
+int c_indent;
+
+// An open block or repeat loop of the statement being translated
+typedef struct
+{
+    int repeat; // Token index of the repeat keyword, -1 for a block
+    int end;    // Token index where it ends: the '}' of a block, or just past the body of a loop
+    int depth;  // Indentation of the loop, which names its counter
+} EmitFrame;
+
+// Stack of the blocks and loops that are open while a statement is translated, so nesting does not use the C stack
+EmitFrame *emit_frames = NULL;
+int emit_frame_capacity = 0;
+
+// Names whose declarations may run zero or several times; they are checked at runtime like in the interpreter
+char *checked_names[MAX_IDENTIFIERS];
+int checked_count = 0;
+
+// Output of constant write items not written to the generated code yet. Consecutive constant items, also those of
+// consecutive write statements, become a single output_write() of one string literal.
+char *pending_text = NULL;
+int pending_length = 0;
+int pending_capacity = 0;
+int pending_indent = 0; // Indentation of the first of them
+
+// Forward declaration
+void emit_pending_text();
+
+// Function to write one indented line of generated code, after the pending constant output
+void emit_line(const char *format, ...)
+{
+    va_list args;
+    if (pending_length > 0)
+        emit_pending_text();
+    for (int i = 0; i < c_indent && i < MAX_C_INDENT && format[0]; i++)
+        fputs("    ", c_out);
+    va_start(args, format);
+    vfprintf(c_out, format, args);
+    va_end(args);
+    fputc('\n', c_out);
+}
+
+// Function to check whether a variable needs runtime declaration checks
+int is_checked(const char *name)
+{
+    for (int i = 0; i < checked_count; i++)
+    {
+        if (strcmp(checked_names[i], name) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Function to find the variables that are declared more than once or inside a block or loop.
+// All other variables are declared exactly once at the top level before any use, so they need no checks.
+void find_checked_variables()
+{
+    int depth = 0;
+    char *top_level[MAX_IDENTIFIERS];
+    int top_level_count = 0;
+
+    for (int i = 0; i + 1 < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_OPENBLOCK)
+            depth++;
+        else if (token_list[i].type == TOKEN_CLOSEBLOCK)
+            depth--;
+
+        // "repeat n times number x;" is not allowed by the parser, so a top-level declaration always runs once
+        if (token_list[i].type != TOKEN_KEYWORD || strcmp(token_list[i].value, "number") != 0)
+            continue;
+
+        char *name = token_list[i + 1].value;
+        int seen = 0;
+        for (int j = 0; j < top_level_count; j++)
+        {
+            if (strcmp(top_level[j], name) == 0)
+                seen = 1;
+        }
+
+        if ((depth > 0 || seen) && !is_checked(name) && checked_count < MAX_IDENTIFIERS)
+            checked_names[checked_count++] = name;
+        if (depth == 0 && !seen && top_level_count < MAX_IDENTIFIERS)
+            top_level[top_level_count++] = name;
+    }
+}
+
+// Function to write the C expression for a constant or variable token into buf. The expression is a
+// const BigInt pointer; constants are parsed once at startup into k<token index>.
+void value_expression(Token *t, char *buf, size_t size)
+{
+    if (t->type == TOKEN_INTCONST)
+    {
+        snprintf(buf, size, "&k%d", (int)(t - token_list));
+    }
+    else if (is_checked(t->value))
+    {
+        snprintf(buf, size, "ppp_get(d_%s, &v_%s, \"%s\", %d)", t->value, t->value, t->value, t->line);
+    }
+    else
+    {
+        snprintf(buf, size, "&v_%s", t->value);
+    }
+}
+
+// Function to check whether the program uses an operator that can fail at runtime (division by zero, negative exponent)
+int uses_checked_arithmetic()
+{
+    for (int i = 0; i < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_OPERATOR &&
+            (strcmp(token_list[i].value, "/=") == 0 || strcmp(token_list[i].value, "%=") == 0 ||
+             strcmp(token_list[i].value, "^=") == 0))
+            return 1;
+    }
+    return 0;
+}
+
+// Function to write a string constant as a C string literal
+void emit_string_literal(const char *s, char *buf, size_t size)
+{
+    size_t n = 0;
+    buf[n++] = '"';
+    for (; *s && n + 6 < size; s++)
+    {
+        unsigned char c = *s;
+        if (c == '\\' || c == '"' || c == '?')
+            n += snprintf(buf + n, size - n, "\\%c", c);
+        else if (c == '\n')
+            n += snprintf(buf + n, size - n, "\\n");
+        else if (c < 32 || c >= 127)
+            n += snprintf(buf + n, size - n, "\\%03o", c);
+        else
+            buf[n++] = c;
+    }
+    buf[n++] = '"';
+    buf[n] = '\0';
+}
+
+// Function to write the pending constant output as one call
+void emit_pending_text()
+{
+    size_t size = (size_t)pending_length * 4 + 8; // Every byte takes at most four characters as an escape
+    char *literal = malloc(size);
+    int length = pending_length;
+    int indent = c_indent;
+    emit_string_literal(pending_text, literal, size);
+    pending_length = 0;
+    c_indent = pending_indent;
+    emit_line("output_write(%s, %d);", literal, length);
+    c_indent = indent;
+    free(literal);
+}
+
+// Function to add the output of a constant write item to the pending output
+void add_pending_text(const char *text, int size)
+{
+    if (pending_length + size + 1 > pending_capacity)
+    {
+        pending_capacity = (pending_length + size + 1) * 2;
+        pending_text = realloc(pending_text, pending_capacity);
+    }
+    if (pending_length == 0)
+        pending_indent = c_indent;
+    memcpy(pending_text + pending_length, text, size);
+    pending_length += size;
+    pending_text[pending_length] = '\0';
+}
+
+// Function to open a block or loop while translating a statement
+void push_emit_frame(int depth, int repeat, int end)
+{
+    if (depth == emit_frame_capacity)
+    {
+        emit_frame_capacity = emit_frame_capacity ? emit_frame_capacity * 2 : 16;
+        emit_frames = realloc(emit_frames, emit_frame_capacity * sizeof(EmitFrame));
+    }
+    emit_frames[depth].repeat = repeat;
+    emit_frames[depth].end = end;
+    emit_frames[depth].depth = c_indent;
+}
+
+// Function to generate the code for a declaration, write or assignment statement starting at token i. Returns the
+// index just past it.
+int emit_simple_statement(int i)
+{
+    Token *t = &token_list[i];
+    char value[256];
+
+    // Declaration: sets the variable to 0
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "number") == 0)
+    {
+        const char *name = token_list[i + 1].value;
+        if (is_checked(name))
+            emit_line("ppp_declare(&d_%s, \"%s\", %d);", name, name, token_list[i + 1].line);
+        emit_line("bigint_set_ll(&v_%s, 0);", name);
+        return i + 3;
+    }
+
+    // Write statement: strings, newlines and constants are rendered now and written together with the constant items
+    // around them; only variables are converted at runtime
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "write") == 0)
+    {
+        for (i++; token_list[i].type != TOKEN_ENDOFLINE; i++)
+        {
+            Token *item = &token_list[i];
+            if (item->type == TOKEN_KEYWORD && strcmp(item->value, "and") == 0)
+                continue;
+
+            if (item->type == TOKEN_STRINGCONST)
+            {
+                add_pending_text(item->value, strlen(item->value));
+            }
+            else if (item->type == TOKEN_KEYWORD)
+            {
+                add_pending_text("\n", 1); // newline
+            }
+            else if (item->type == TOKEN_INTCONST)
+            {
+                BigInt constant = {0};
+                bigint_parse(&constant, item->value);
+                char *text = malloc(bigint_decimal_size(&constant));
+                add_pending_text(text, bigint_to_decimal(&constant, text));
+                free(text);
+                bigint_free(&constant);
+            }
+            else
+            {
+                value_expression(item, value, sizeof(value));
+                emit_line("output_bigint(%s);", value);
+            }
+        }
+        return i + 1;
+    }
+
+    // Read statement: the next number of the input, checked like the arithmetic that can fail
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "read") == 0)
+    {
+        const char *name = token_list[i + 1].value;
+        if (is_checked(name))
+            emit_line("ppp_check(d_%s, \"%s\", %d);", name, name, token_list[i + 1].line);
+        emit_line("ppp_read(input_read(&v_%s), %d);", name, token_list[i + 1].line);
+        return i + 3;
+    }
+
+    // Assignment and arithmetic statements: one bigint call, checked when it can fail
+    Token *op = &token_list[i + 1];
+    const char *function = "bigint_copy";
+    if (strcmp(op->value, "+=") == 0)
+        function = "bigint_add";
+    else if (strcmp(op->value, "-=") == 0)
+        function = "bigint_sub";
+    else if (strcmp(op->value, "*=") == 0)
+        function = "bigint_mul";
+    else if (strcmp(op->value, "/=") == 0)
+        function = "bigint_div";
+    else if (strcmp(op->value, "%=") == 0)
+        function = "bigint_mod";
+    else if (strcmp(op->value, "^=") == 0)
+        function = "bigint_pow";
+    int can_fail = strcmp(op->value, "/=") == 0 || strcmp(op->value, "%=") == 0 || strcmp(op->value, "^=") == 0;
+
+    char call[512];
+    value_expression(&token_list[i + 2], value, sizeof(value)); // The right side is read first
+    if (is_checked(t->value))
+    {
+        emit_line("{");
+        emit_line("    const BigInt *rhs = %s;", value);
+        emit_line("    ppp_check(d_%s, \"%s\", %d);", t->value, t->value, t->line);
+        snprintf(call, sizeof(call), "%s(&v_%s, rhs)", function, t->value);
+        c_indent++;
+    }
+    else
+    {
+        snprintf(call, sizeof(call), "%s(&v_%s, %s)", function, t->value, value);
+    }
+
+    if (can_fail)
+        emit_line("ppp_arithmetic(%s, %d);", call, op->line);
+    else
+        emit_line("%s;", call);
+
+    if (is_checked(t->value))
+    {
+        c_indent--;
+        emit_line("}");
+    }
+    return i + 4;
+}
+
+// Function to generate the code for the statement starting at token i. Returns the index just past it.
+int emit_statement(int i)
+{
+    int depth = 0; // Blocks and loops opened by this statement and not closed yet
+    char value[256];
+
+    do
+    {
+        Token *t = &token_list[i];
+
+        // Block: its statements in a C block
+        if (t->type == TOKEN_OPENBLOCK)
+        {
+            push_emit_frame(depth++, -1, statement_end(i) - 1);
+            emit_line("{");
+            c_indent++;
+            i++;
+        }
+
+        // Repeat loop: the count is read once and a count variable holds the iterations left
+        else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "repeat") == 0)
+        {
+            Token *count_tok = &token_list[i + 1];
+            int is_variable = count_tok->type == TOKEN_IDENTIFIER;
+            const char *name = count_tok->value;
+            int loop = c_indent; // Unique enough: loops at the same depth never overlap
+
+            push_emit_frame(depth++, i, statement_end(i + 3));
+            value_expression(count_tok, value, sizeof(value));
+            emit_line("{");
+            c_indent++;
+            emit_line("long long left%d = bigint_clamp(%s);", loop, value);
+            if (is_variable)
+            {
+                emit_line("if (left%d < 1)", loop);
+                emit_line("    bigint_set_ll(&v_%s, 0);", name);
+            }
+            emit_line("while (left%d >= 1)", loop);
+            emit_line("{");
+            c_indent++;
+            i += 3; // The body follows "repeat <count> times"
+        }
+
+        else
+        {
+            i = emit_simple_statement(i);
+        }
+
+        // Close the blocks and loops that end here
+        while (depth > 0 && i == emit_frames[depth - 1].end)
+        {
+            const EmitFrame *f = &emit_frames[--depth];
+            if (f->repeat < 0)
+            {
+                c_indent--;
+                emit_line("}");
+                i++; // Skip the '}'
+                continue;
+            }
+
+            const Token *count_tok = &token_list[f->repeat + 1];
+            emit_line("left%d--;", f->depth);
+            if (count_tok->type == TOKEN_IDENTIFIER)
+                emit_line("bigint_set_ll(&v_%s, left%d);", count_tok->value, f->depth);
+            c_indent--;
+            emit_line("}");
+            c_indent--;
+            emit_line("}");
+        }
+    } while (depth > 0);
+
+    return i;
+}
+
+// Function to generate the whole C program
+void emit_c_program(FILE *out, const char *source_file)
+{
+    int reads_input = program_reads_input();
+    c_out = out;
+    c_indent = 0;
+    checked_count = 0;
+    find_block_ends();
+    find_checked_variables();
+
+    emit_line("/* Generated by ppp --emit-c from %s.", source_file);
+    emit_line("   Build it together with the interpreter's output, input and big integer runtime:");
+    emit_line("   cc -O2 -pthread -o program program.c output.c bigint.c ntt.c memory.c input.c */");
+    emit_line("#include <stdio.h>");
+    emit_line("#include <stdlib.h>");
+    emit_line("#include \"output.h\"");
+    emit_line("#include \"bigint.h\"");
+    if (reads_input)
+        emit_line("#include \"input.h\"");
+    emit_line("");
+
+    if (reads_input)
+    {
+        emit_line("// Runtime check for the end of the input and numbers that cannot be read");
+        emit_line("static void ppp_read(int status, int line)");
+        emit_line("{");
+        emit_line("    if (status != INPUT_OK)");
+        emit_line("    {");
+        emit_line("        fprintf(stderr, \"[ERROR] (line %%d): %%s\\n\", line, input_error(status));");
+        emit_line("        exit(1);");
+        emit_line("    }");
+        emit_line("}");
+        emit_line("");
+    }
+
+    if (uses_checked_arithmetic())
+    {
+        emit_line("// Runtime check for division by zero and negative exponents");
+        emit_line("static void ppp_arithmetic(int status, int line)");
+        emit_line("{");
+        emit_line("    if (status != BIGINT_OK)");
+        emit_line("    {");
+        emit_line("        fprintf(stderr, \"[ERROR] (line %%d): %%s\\n\", line, bigint_error(status));");
+        emit_line("        exit(1);");
+        emit_line("    }");
+        emit_line("}");
+        emit_line("");
+    }
+
+    if (checked_count > 0)
+    {
+        emit_line("// Runtime checks for variables whose declarations may not run exactly once");
+        emit_line("static void ppp_check(int declared, const char *name, int line)");
+        emit_line("{");
+        emit_line("    if (!declared)");
+        emit_line("    {");
+        emit_line("        fprintf(stderr, \"[ERROR] (line %%d): Variable '%%s' is not declared.\\n\", line, name);");
+        emit_line("        exit(1);");
+        emit_line("    }");
+        emit_line("}");
+        emit_line("");
+        emit_line("static const BigInt *ppp_get(int declared, const BigInt *value, const char *name, int line)");
+        emit_line("{");
+        emit_line("    if (!declared)");
+        emit_line("    {");
+        emit_line("        fprintf(stderr, \"[ERROR] (line %%d): Variable '%%s' not declared.\\n\", line, name);");
+        emit_line("        exit(1);");
+        emit_line("    }");
+        emit_line("    return value;");
+        emit_line("}");
+        emit_line("");
+        emit_line("static void ppp_declare(int *declared, const char *name, int line)");
+        emit_line("{");
+        emit_line("    if (*declared)");
+        emit_line("    {");
+        emit_line("        fprintf(stderr, \"[ERROR] (line %%d): Variable '%%s' already declared.\\n\", line, name);");
+        emit_line("        exit(1);");
+        emit_line("    }");
+        emit_line("    *declared = 1;");
+        emit_line("}");
+        emit_line("");
+    }
+
+    emit_line(reads_input ? "int main(int argc, char *argv[])" : "int main(void)");
+    emit_line("{");
+    c_indent++;
+
+    // Every declared name becomes one C variable (taken from the tokens, since the lexer does not run for cached programs)
+    for (int i = 0; i + 1 < token_count; i++)
+    {
+        if (token_list[i].type != TOKEN_KEYWORD || strcmp(token_list[i].value, "number") != 0)
+            continue;
+
+        const char *name = token_list[i + 1].value;
+        int first = 1;
+        for (int j = 0; j < i && first; j++)
+        {
+            if (token_list[j].type == TOKEN_KEYWORD && strcmp(token_list[j].value, "number") == 0 &&
+                strcmp(token_list[j + 1].value, name) == 0)
+                first = 0;
+        }
+        if (!first)
+            continue;
+
+        emit_line("BigInt v_%s = {0};", name);
+        if (is_checked(name))
+            emit_line("int d_%s = 0;", name);
+    }
+
+    // Constants are converted once, like the compiled loop bodies do
+    for (int i = 0; i < token_count; i++)
+    {
+        if (token_list[i].type != TOKEN_INTCONST)
+            continue;
+        emit_line("BigInt k%d = {0};", i);
+        emit_line("bigint_parse(&k%d, \"%s\");", i, token_list[i].value);
+    }
+    emit_line("");
+    emit_line("atexit(output_flush);");
+    if (reads_input)
+    {
+        emit_line("if (argc > 1)");
+        emit_line("    input_file = argv[1]; // Numbers come from this file instead of stdin");
+    }
+    emit_line("");
+
+    for (int i = 0; i < token_count;)
+        i = emit_statement(i);
+
+    emit_line("return 0;");
+    c_indent--;
+    emit_line("}");
+}
@@ -0,0 +1,10 @@
+// emit_c.h
+#ifndef EMIT_C_H
+#define EMIT_C_H
+
+#include <stdio.h>
+
+// Translates the parsed program into a standalone C program that uses the output runtime (output.c)
+void emit_c_program(FILE *out, const char *source_file);
+
+#endif
@@ -0,0 +1,15 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "error.h"
+
+jmp_buf *error_recovery = NULL;
+
+// Function to stop the current program after an error message was printed
+_Noreturn void error_exit()
+{
+    if (error_recovery)
+    {
+        longjmp(*error_recovery, 1);
+    }
+    exit(1);
+}
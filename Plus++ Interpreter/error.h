@@ -0,0 +1,13 @@
+// error.h
+#ifndef ERROR_H
+#define ERROR_H
+
+#include <setjmp.h>
+
+// When set, program errors jump here instead of ending the process (used by the REPL to keep its session alive)
+extern jmp_buf *error_recovery;
+
+// Stops after a syntax or runtime error has been reported: exits with status 1, or jumps to error_recovery if it is set
+_Noreturn void error_exit();
+
+#endif
@@ -1,30 +1,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "file_utils.h"
 
-// Gets the name of the source file to be used.
+// Gets the name of the source file given as the first command line argument.
 void get_source_filename(int argc, char *argv[], char *filename, size_t size)
 {
-
-    // If the user provides it as a command line argument, it's used directly.
-    if (argc >= 2)
+    // The program is run without a source file only in the REPL, so the name is always on the command line.
+    if (argc < 2)
     {
-        snprintf(filename, size, "%s.ppp", argv[1]);
+        fprintf(stderr, "No source file given.\n");
+        exit(1);
     }
-    else
-    {
+    source_filename(argv[1], filename, size);
+}
 
-        // Otherwise, the program asks the user to enter a name.
-        char input[256];
-        printf("Enter source file name (without extension): ");
-        if (fgets(input, sizeof(input), stdin) == NULL)
-        {
-            fprintf(stderr, "Failed to read input.\n");
-            exit(1);
-        }
-        input[strcspn(input, "\r\n")] = 0;
-        snprintf(filename, size, "%s.ppp", input); /// The ".ppp" extension is automatically added.
-    }
+// Gets the name of the source file of a program or module name.
+void source_filename(const char *name, char *filename, size_t size)
+{
+    snprintf(filename, size, "%s.ppp", name); /// The ".ppp" extension is automatically added.
 }
 
 // Tries to open the source file for reading.
@@ -40,3 +34,50 @@ FILE *open_source_file(const char *filename)
     }
     return file;
 }
+
+// Opens a string as a read-only stream, so it can be tokenized like a source file.
+FILE *open_string_stream(const char *text)
+{
+    return open_text_stream(text, strlen(text));
+}
+
+// Opens the first length characters of a text as a read-only stream, without looking at the rest of it.
+FILE *open_text_stream(const char *text, size_t length)
+{
+#ifdef _WIN32
+    // No fmemopen() on Windows, so go through a temporary file instead.
+    FILE *file = tmpfile();
+    if (file)
+    {
+        fwrite(text, 1, length, file);
+        rewind(file);
+    }
+    return file;
+#else
+    return fmemopen((void *)text, length, "r");
+#endif
+}
+
+// Function to read a whole file into a string; NULL if it cannot be read
+char *read_text_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    size_t length = 0, capacity = 4096;
+    char *text = malloc(capacity);
+    size_t n;
+    while ((n = fread(text + length, 1, capacity - length - 1, file)) > 0)
+    {
+        length += n;
+        if (length + 1 == capacity)
+        {
+            capacity *= 2;
+            text = realloc(text, capacity);
+        }
+    }
+    fclose(file);
+    text[length] = '\0';
+    return text;
+}
@@ -6,7 +6,19 @@
 // Function to get the name of the source file to be used in the program.
 void get_source_filename(int argc, char *argv[], char *filename, size_t size);
 
+// Function to get the source file of a program or module name (name.ppp), used for the command line and include.
+void source_filename(const char *name, char *filename, size_t size);
+
 // Function to open the given source file for reading.
 FILE *open_source_file(const char *filename);
 
+// Function to open an in-memory string for reading like a file.
+FILE *open_string_stream(const char *text);
+
+// Function to open the first length characters of an in-memory text for reading like a file.
+FILE *open_text_stream(const char *text, size_t length);
+
+// Function to read a whole file into a string (to be freed by the caller); NULL if it cannot be read.
+char *read_text_file(const char *path);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "incremental.h"
+#include "lexer.h"
+#include "parser.h"
+#include "file_utils.h"
+#include "error.h"
+#include "bench.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// External variables declared in the parser
+extern int current;
+extern Token *last_token;
+
+// Longest identifier name, with its terminator (the lexer rejects names over 20 characters)
+#define NAME_SIZE 24
+
+// Slots of the table of identifier counts; it is rebuilt once half of them are in use
+#define NAME_TABLE_SIZE 4096
+
+// Most names that can be waiting for a declaration at the same time
+#define MAX_MISSING_NAMES 256
+
+// Most separate changed parts of the tokens the syntax check keeps apart
+#define MAX_DIRTY_REGIONS 16
+
+// The source text being edited
+char *source_text = NULL;
+int source_length = 0;
+int source_capacity = 0;
+
+// Part of the source the tokens do not describe yet, because re-lexing it failed: the tokens still describe the
+// text from before, in which [pending_start, pending_old_end) is now [pending_start, pending_new_end) and there are
+// pending_lines more line breaks. pending_start is -1 when the tokens describe the whole source.
+int pending_start = -1;
+int pending_old_end = 0;
+int pending_new_end = 0;
+int pending_lines = 0;
+
+// Token positions are shifted lazily: the tokens from shift_from on are shift_offset characters and shift_lines lines
+// behind their place in the source. They also sit gap_length places further in the token list, so tokens can be
+// inserted and removed at shift_from without moving them. An edit moves shift_from to itself, so only the tokens
+// between two edits are updated and moved, and the tail of the token list is left alone.
+int shift_from = 0;
+int shift_offset = 0;
+int shift_lines = 0;
+int gap_length = 0;
+
+// Brace structure of a token range: the number of '{' minus '}', and the lowest that number reaches in the range
+typedef struct
+{
+    int balance;
+    int lowest;
+} BraceShape;
+
+// A part of the tokens, [first, end), that changed since the program last passed the syntax check, when its braces
+// had the shape before. parsed is 1 once it parsed on its own up to its end, with the braces shaped like after, and
+// failed is 1 after a syntax error in it.
+typedef struct
+{
+    int first;
+    int end;
+    BraceShape before;
+    BraceShape after;
+    int parsed;
+    int failed;
+} DirtyRegion;
+
+// The changed parts, in token order and apart from each other; none while the syntax is valid. Edits far apart get
+// a region each, so one that is fixed again is not parsed together with everything up to the other.
+DirtyRegion dirty_regions[MAX_DIRTY_REGIONS + 1];
+int dirty_count = 0;
+
+// Names used without a declaration, or whose declaration was removed while tokens of the name remain. Each is an error
+// until the next token of the name from missing_from[i] on turns out to be declared.
+char missing_names[MAX_MISSING_NAMES][NAME_SIZE];
+int missing_from[MAX_MISSING_NAMES];
+int missing_count = 0;
+
+// Names the lexer found undeclared while re-lexing, with the place of their first token among the new ones. They wait
+// for a declaration like the missing names, so an undeclared name does not stop the tokens after it from being reused.
+char undeclared_names[MAX_MISSING_NAMES][NAME_SIZE];
+int undeclared_tokens[MAX_MISSING_NAMES];
+int undeclared_count = 0;
+
+// Number of identifier tokens of each name, so a name that lost its declaration and is not used needs no scan
+typedef struct
+{
+    char name[NAME_SIZE];
+    int count;
+} NameCount;
+
+NameCount name_counts[NAME_TABLE_SIZE];
+int name_slots = 0;
+
+// Declarations from the re-lexed statement on, put aside while the lexer must only see the ones before it
+char saved_names[MAX_IDENTIFIERS][NAME_SIZE];
+int saved_tokens[MAX_IDENTIFIERS];
+int saved_count = 0;
+
+// Buffer the re-lexed tokens are moved in place through
+Token *splice_buffer = NULL;
+int splice_capacity = 0;
+
+// State of the re-lexing of one edit, used by catch_up_with_old_tokens()
+int sync_first;     // First old token that is being re-lexed
+int sync_old_count; // Number of tokens before re-lexing
+int sync_new_first; // Place in the token list of the first new token, after the old ones and the gap
+int sync_edit_end;  // End of the changed text in the new source
+int sync_delta;     // Change of the source length caused by the change
+int sync_index;     // Old token at which the new tokens caught up, -1 if they did not
+
+int check_source_from_scratch();
+
+// Function to get a token, skipping the gap in the token list
+Token *token_at(int i)
+{
+    return &token_list[i < shift_from ? i : i + gap_length];
+}
+
+// Function to get the offset of a token in the source
+int token_offset_at(int i)
+{
+    return i < shift_from ? token_list[i].offset : token_list[i + gap_length].offset + shift_offset;
+}
+
+// Function to check for a token of an included module. All tokens of an include statement start where it does, and
+// the ones between its first and last token keep their lines in the module file, so edits do not move them.
+int is_module_token(int i)
+{
+    if (i == 0 || i + 1 >= token_count)
+        return 0;
+    int offset = token_offset_at(i);
+    return token_offset_at(i - 1) == offset && token_offset_at(i + 1) == offset;
+}
+
+// Function to get the line of a token in the source (or in its module)
+int token_line_at(int i)
+{
+    if (i < shift_from)
+        return token_list[i].line;
+    return token_list[i + gap_length].line + (is_module_token(i) ? 0 : shift_lines);
+}
+
+// Function to get the offset just past the last character of a token
+int token_end_at(int i)
+{
+    return token_offset_at(i) + token_at(i)->length;
+}
+
+// Function to move the point from which tokens lag behind, with the gap, updating the tokens in between or letting
+// them lag as well
+void move_shift(int index)
+{
+    // Lines first, while the offsets still tell which tokens belong to a module
+    if (index > shift_from)
+    {
+        for (int i = shift_from; i < index; i++)
+        {
+            if (!is_module_token(i))
+                token_list[i + gap_length].line += shift_lines;
+        }
+        memmove(&token_list[shift_from], &token_list[shift_from + gap_length], (index - shift_from) * sizeof(Token));
+        for (int i = shift_from; i < index; i++)
+            token_list[i].offset += shift_offset;
+    }
+    else if (index < shift_from)
+    {
+        for (int i = index; i < shift_from; i++)
+        {
+            if (!is_module_token(i))
+                token_list[i].line -= shift_lines;
+        }
+        memmove(&token_list[index + gap_length], &token_list[index], (shift_from - index) * sizeof(Token));
+        for (int i = index + gap_length; i < shift_from + gap_length; i++)
+            token_list[i].offset -= shift_offset;
+    }
+    shift_from = index;
+    if (shift_from == token_count)
+        gap_length = 0;
+}
+
+// Function to bring the positions of all tokens up to date, and close the gap so the token list is in one piece
+void update_token_positions()
+{
+    move_shift(token_count);
+    shift_offset = 0;
+    shift_lines = 0;
+}
+
+// Function to tell what a token means for the identifier a "number" declares: the lexer expects it after "number" (1)
+// until the next identifier (0), whatever comes in between (-1)
+int declaration_state(const Token *t)
+{
+    if (t->type == TOKEN_IDENTIFIER)
+        return 0;
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "number") == 0)
+        return 1;
+    return -1;
+}
+
+// Function to check if token i of a list of count tokens ends a statement or opens/closes a block, so a statement
+// starts after it. The tokens of an included module all span the include statement and do not count, and neither does
+// a ';', '{' or '}' the lexer reaches while it still expects the identifier a "number" declares.
+int ends_statement(int i, int count)
+{
+    TokenType type = token_at(i)->type;
+    if (type != TOKEN_ENDOFLINE && type != TOKEN_OPENBLOCK && type != TOKEN_CLOSEBLOCK)
+        return 0;
+    int state = -1;
+    for (int j = i; j >= 0 && state < 0; j--)
+        state = declaration_state(token_at(j));
+    if (state == 1)
+        return 0;
+    return i + 1 >= count || token_offset_at(i + 1) >= token_end_at(i);
+}
+
+// Function to count the line breaks in a piece of text
+int count_lines(const char *text, int length)
+{
+    int lines = 0;
+    for (int i = 0; i < length; i++)
+    {
+        if (text[i] == '\n')
+            lines++;
+    }
+    return lines;
+}
+
+// Function to replace part of the source text, growing the buffer if needed
+void replace_text(int offset, int removed_length, const char *inserted, int inserted_length)
+{
+    int new_length = source_length - removed_length + inserted_length;
+    if (new_length + 1 > source_capacity)
+    {
+        source_capacity = (new_length + 1) * 2;
+        source_text = realloc(source_text, source_capacity);
+        source_text[source_length] = '\0';
+    }
+
+    memmove(source_text + offset + inserted_length, source_text + offset + removed_length,
+            source_length - offset - removed_length + 1); // Include the terminator
+    memcpy(source_text + offset, inserted, inserted_length);
+    source_length = new_length;
+}
+
+// Function to add an edit of the source to the part that has to be re-lexed. start, old_end and lines are those of
+// the edit in the text before it, new_end the end of the inserted text after it.
+void add_pending_edit(int start, int old_end, int new_end, int lines)
+{
+    if (pending_start < 0)
+    {
+        pending_start = start;
+        pending_old_end = old_end;
+        pending_new_end = new_end;
+        pending_lines = lines;
+        return;
+    }
+
+    // Cover both changes: text past the end of the pending one maps back by the length it changed by
+    int end = pending_new_end;
+    if (old_end > end)
+    {
+        pending_old_end += old_end - end;
+        end = old_end;
+    }
+    pending_new_end = end + (new_end - old_end);
+    if (start < pending_start)
+        pending_start = start;
+    pending_lines += lines;
+}
+
+// Function to find the slot of a name in the table of identifier counts
+NameCount *name_slot(const char *name)
+{
+    unsigned hash = 2166136261u;
+    for (const char *p = name; *p; p++)
+        hash = (hash ^ (unsigned char)*p) * 16777619u;
+
+    unsigned i = hash % NAME_TABLE_SIZE;
+    while (name_counts[i].name[0] && strcmp(name_counts[i].name, name) != 0)
+        i = (i + 1) % NAME_TABLE_SIZE;
+    return &name_counts[i];
+}
+
+// Function to add change to the counts of the identifier tokens in [start, end)
+void count_names(int start, int end, int change)
+{
+    for (int i = start; i < end; i++)
+    {
+        const Token *t = token_at(i);
+        if (t->type != TOKEN_IDENTIFIER)
+            continue;
+        NameCount *slot = name_slot(t->value);
+        if (!slot->name[0])
+        {
+            strcpy(slot->name, t->value);
+            name_slots++;
+        }
+        slot->count += change;
+    }
+}
+
+// Function to count the identifiers of the whole token list again, dropping the names that are not used any more
+void recount_names()
+{
+    memset(name_counts, 0, sizeof(name_counts));
+    name_slots = 0;
+    count_names(0, token_count, 1);
+}
+
+// Function to get the number of declarations that come before a token
+int declarations_before(int index)
+{
+    int low = 0, high = declared_count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (declared_tokens[mid] <= index)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Function to put the declarations from the first kept one on aside, and hide them from the lexer
+void save_declarations(int kept)
+{
+    saved_count = declared_count - kept;
+    for (int i = 0; i < saved_count; i++)
+    {
+        strcpy(saved_names[i], declared_identifiers[kept + i]);
+        saved_tokens[i] = declared_tokens[kept + i];
+    }
+    forget_identifiers(kept);
+}
+
+// Function to declare the saved declarations again from the first one at token from on, with their tokens moved by
+// shift
+void restore_declarations(int from, int shift)
+{
+    for (int i = 0; i < saved_count; i++)
+    {
+        if (saved_tokens[i] < from)
+            continue;
+        declare_identifier(saved_names[i]);
+        declared_tokens[declared_count - 1] = saved_tokens[i] + shift;
+    }
+}
+
+// Function to check whether count tokens in a row have the tokens of an included module
+int has_module(const Token *tokens, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (tokens[i].type == TOKEN_OPENBLOCK && tokens[i].value[0])
+            return 1;
+    }
+    return 0;
+}
+
+// Function to get the brace structure of tokens [start, end)
+BraceShape brace_shape(int start, int end)
+{
+    BraceShape shape = {0, 0};
+    for (int i = start; i < end; i++)
+    {
+        TokenType type = token_at(i)->type;
+        if (type == TOKEN_OPENBLOCK)
+        {
+            shape.balance++;
+        }
+        else if (type == TOKEN_CLOSEBLOCK)
+        {
+            if (--shape.balance < shape.lowest)
+                shape.lowest = shape.balance;
+        }
+    }
+    return shape;
+}
+
+// Function to get the brace structure of two ranges that follow each other
+BraceShape join_shapes(BraceShape a, BraceShape b)
+{
+    BraceShape shape = {a.balance + b.balance, a.lowest};
+    if (a.balance + b.lowest < shape.lowest)
+        shape.lowest = a.balance + b.lowest;
+    return shape;
+}
+
+// Stop hook for the lexer: re-lexing can stop at a ';', '{' or '}' past the change that ends at the same place
+// (shifted by the change) as an old token of the same type, since everything after it is unchanged
+int catch_up_with_old_tokens(const Token *t)
+{
+    int end = t->offset + t->length;
+    if (end < sync_edit_end)
+        return 0;
+
+    // The lexer would still declare the next identifier after "number", whatever followed in the old tokens
+    int state = -1;
+    for (int i = token_count - 1; i >= sync_new_first && state < 0; i--)
+        state = declaration_state(&token_list[i]);
+    for (int i = sync_first - 1; i >= 0 && state < 0; i--)
+        state = declaration_state(token_at(i));
+    if (state == 1)
+        return 0;
+
+    // Old tokens are sorted by offset, so find the last one ending at or before the same place with a binary search.
+    // The tokens of an included module share their end; the last of them is the '}' closing the module.
+    int old_end = end - sync_delta;
+    int low = sync_first, high = sync_old_count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (token_end_at(mid) <= old_end)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    int match = low - 1;
+    if (match < sync_first || token_end_at(match) != old_end || token_at(match)->type != t->type ||
+        !ends_statement(match, sync_old_count))
+        return 0;
+    sync_index = match;
+    return 1;
+}
+
+// Handler for the identifiers the lexer finds undeclared while re-lexing. Returns 0 once too many names wait.
+int keep_undeclared_identifier(const Token *t)
+{
+    for (int i = 0; i < undeclared_count; i++)
+    {
+        if (strcmp(undeclared_names[i], t->value) == 0)
+            return 1;
+    }
+    if (undeclared_count == MAX_MISSING_NAMES)
+        return 0;
+    strcpy(undeclared_names[undeclared_count], t->value);
+    undeclared_tokens[undeclared_count++] = (int)(t - token_list) - sync_new_first;
+    return 1;
+}
+
+// Function to tokenize the source from an offset until the tokens catch up with the old ones, appending them to the
+// token list. Returns 0 after a lexical error.
+int relex(int start_offset, int start_line)
+{
+    jmp_buf recovery;
+    FILE *in = open_text_stream(source_text + start_offset, source_length - start_offset);
+    if (!in)
+        return 0;
+
+    if (setjmp(recovery) != 0)
+    {
+        error_recovery = NULL;
+        tokenize_stop_hook = NULL;
+        undeclared_identifier_hook = NULL;
+        fclose(in);
+        return 0;
+    }
+    error_recovery = &recovery;
+    tokenize_stop_hook = catch_up_with_old_tokens;
+    undeclared_identifier_hook = keep_undeclared_identifier;
+    tokenize_at(in, NULL, start_line, start_offset);
+    tokenize_stop_hook = NULL;
+    undeclared_identifier_hook = NULL;
+    error_recovery = NULL;
+    fclose(in);
+    return 1;
+}
+
+// Function to parse tokens [start, end) on their own with parse_range(). The tokens after them are hidden from the
+// parser, as they may be behind the gap. Returns 0 after a syntax error.
+int parse_tokens(int start, int end, BraceShape *shape)
+{
+    jmp_buf recovery;
+    int count = token_count;
+    if (setjmp(recovery) != 0)
+    {
+        error_recovery = NULL;
+        token_count = count;
+        return 0;
+    }
+    error_recovery = &recovery;
+    token_count = end;
+    current = start;
+    shape->balance = parse_range(end, &shape->lowest);
+    error_recovery = NULL;
+    token_count = count;
+    return 1;
+}
+
+// Function to parse the whole token list. Returns 0 after a syntax error.
+int parse_all_tokens()
+{
+    jmp_buf recovery;
+    if (setjmp(recovery) != 0)
+    {
+        error_recovery = NULL;
+        return 0;
+    }
+    error_recovery = &recovery;
+    current = 0;
+    last_token = NULL;
+    parse_statements();
+    error_recovery = NULL;
+    return 1;
+}
+
+// Function to add tokens [first, end), replaced by new_count tokens, to the changed parts. Overlapping and
+// adjoining regions are merged with them; their braces before are joined with those of the unchanged tokens between
+// them. Returns the index of the region.
+int add_dirty_region(int first, int end, int new_count)
+{
+    int low = 0;
+    while (low < dirty_count && dirty_regions[low].end < first)
+        low++;
+    int high = low;
+    while (high < dirty_count && dirty_regions[high].first <= end)
+        high++;
+
+    DirtyRegion region = {first, end, {0, 0}, {0, 0}, 0, 0};
+    if (high > low && dirty_regions[low].first < region.first)
+        region.first = dirty_regions[low].first;
+    if (high > low && dirty_regions[high - 1].end > region.end)
+        region.end = dirty_regions[high - 1].end;
+
+    int covered = region.first;
+    for (int r = low; r < high; r++)
+    {
+        region.before = join_shapes(region.before, brace_shape(covered, dirty_regions[r].first));
+        region.before = join_shapes(region.before, dirty_regions[r].before);
+        covered = dirty_regions[r].end;
+    }
+    region.before = join_shapes(region.before, brace_shape(covered, region.end));
+
+    // The regions after it move with the change of the number of tokens
+    int shift = new_count - (end - first);
+    region.end += shift;
+    for (int r = high; r < dirty_count; r++)
+    {
+        dirty_regions[r].first += shift;
+        dirty_regions[r].end += shift;
+    }
+    memmove(&dirty_regions[low + 1], &dirty_regions[high], (dirty_count - high) * sizeof(DirtyRegion));
+    dirty_count += low + 1 - high;
+    dirty_regions[low] = region;
+    return low;
+}
+
+// Function to keep the number of changed regions within MAX_DIRTY_REGIONS, once the tokens are in place: the region
+// at index takes in the nearest of its neighbours. Returns the new index of the region.
+int limit_dirty_regions(int index)
+{
+    if (dirty_count <= MAX_DIRTY_REGIONS)
+        return index;
+
+    int left = index;
+    if (index + 1 == dirty_count ||
+        (index > 0 && dirty_regions[index].first - dirty_regions[index - 1].end <
+                          dirty_regions[index + 1].first - dirty_regions[index].end))
+        left = index - 1;
+
+    DirtyRegion *a = &dirty_regions[left], *b = &dirty_regions[left + 1];
+    a->before = join_shapes(join_shapes(a->before, brace_shape(a->end, b->first)), b->before);
+    a->end = b->end;
+    memmove(b, b + 1, (dirty_count - left - 2) * sizeof(DirtyRegion));
+    dirty_count--;
+    return left;
+}
+
+// Function to parse a changed region on its own. A statement that does not end with it is left to a parse of the
+// whole program.
+void parse_dirty_region(DirtyRegion *region)
+{
+    move_shift(region->end);
+    region->parsed = parse_tokens(region->first, region->end, &region->after);
+    region->failed = !region->parsed && current < region->end; // Not when the last statement goes on past the region
+}
+
+// Function to check the syntax after the tokens of the changed region at index were replaced. Every region holds all
+// that changed there since the program was last valid, and the statements around the regions are unchanged and were
+// valid. Between statements the parser only keeps the number of open blocks, so parsing the changed regions on their
+// own is enough as long as each leaves the same number of blocks open and closes no more than before. Only when the
+// braces moved in other ways is the whole program parsed, to find the '}' that no longer has a block to close.
+int check_syntax(int index)
+{
+    parse_dirty_region(&dirty_regions[index]);
+
+    int whole = 0, opened = 0;
+    for (int r = 0; r < dirty_count; r++)
+    {
+        DirtyRegion *region = &dirty_regions[r];
+        if (region->failed)
+            return 0; // Reported when the region was parsed
+        if (!region->parsed || region->after.lowest < region->before.lowest ||
+            region->after.balance < region->before.balance)
+            whole = 1;
+        else
+            opened += region->after.balance - region->before.balance;
+    }
+
+    int valid;
+    if (whole)
+    {
+        update_token_positions();
+        valid = parse_all_tokens();
+    }
+    else if (opened > 0)
+    {
+        // The blocks left open are still open at the end of the program
+        fprintf(stderr, "[ERROR]: Unexpected end of input in block.\n");
+        valid = 0;
+    }
+    else
+    {
+        valid = 1;
+    }
+
+    if (valid)
+        dirty_count = 0;
+    return valid;
+}
+
+// Function to add a name to the ones waiting for a declaration, looking for its tokens from a token on
+void add_missing_name(const char *name, int from)
+{
+    for (int i = 0; i < missing_count; i++)
+    {
+        if (strcmp(missing_names[i], name) == 0)
+        {
+            if (from < missing_from[i])
+                missing_from[i] = from;
+            return;
+        }
+    }
+    strcpy(missing_names[missing_count], name);
+    missing_from[missing_count++] = from;
+}
+
+// Function to check whether a name is declared before a token, or by it
+int is_declared_by(const char *name, int index)
+{
+    for (int i = 0; i < declared_count && declared_tokens[i] <= index; i++)
+    {
+        if (strcmp(declared_identifiers[i], name) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Function to check the names waiting for a declaration: the next token of each must be declared by then. Reports the
+// first token that is not and returns 0 if there is one.
+int check_missing_names()
+{
+    int error = -1;
+    for (int m = 0; m < missing_count;)
+    {
+        const char *name = missing_names[m];
+        int i = missing_from[m];
+        if (name_slot(name)->count == 0)
+        {
+            i = token_count;
+        }
+        else
+        {
+            while (i < token_count && !(token_at(i)->type == TOKEN_IDENTIFIER && strcmp(token_at(i)->value, name) == 0))
+                i++;
+        }
+
+        if (i == token_count || is_declared_by(name, i))
+        {
+            // Nothing left to declare, or declared before it is used
+            missing_count--;
+            memmove(missing_names[m], missing_names[missing_count], NAME_SIZE);
+            missing_from[m] = missing_from[missing_count];
+            continue;
+        }
+        missing_from[m] = i;
+        if (error < 0 || i < error)
+            error = i;
+        m++;
+    }
+
+    if (error >= 0)
+    {
+        fprintf(stderr, "[ERROR] (Line %d): '%s' is not defined\n", token_line_at(error), token_at(error)->value);
+        return 0;
+    }
+    return 1;
+}
+
+// Function to bring the tokens and the syntax check up to date with the pending change of the source. Only the
+// statements the change touches are re-lexed and re-parsed.
+int relex_pending()
+{
+    int delta = pending_new_end - pending_old_end;
+    if (name_slots > NAME_TABLE_SIZE / 2)
+        recount_names();
+
+    // Find the first token ending after the change start, then go back to the start of its statement
+    int low = 0, high = token_count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (token_end_at(mid) <= pending_start)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    int first = low;
+    while (first > 0 && !ends_statement(first - 1, token_count))
+        first--;
+
+    int start_offset = first > 0 ? token_end_at(first - 1) : 0;
+    int start_line = first > 0 ? token_line_at(first - 1) : 1;
+    int old_count = token_count;
+    move_shift(first);
+
+    // The lexer checks identifiers against the declarations before the re-lexed part
+    int kept = declarations_before(first);
+    save_declarations(kept);
+
+    // Re-lex from the statement start until the new tokens line up with the old ones again. The new tokens are
+    // appended after the old ones, which follow the gap from the statement start on, so both can be compared.
+    int list_end = old_count + gap_length;
+    sync_first = first;
+    sync_old_count = old_count;
+    sync_new_first = list_end;
+    sync_edit_end = pending_new_end;
+    sync_delta = delta;
+    sync_index = -1;
+    undeclared_count = 0;
+    token_count = list_end;
+    if (start_offset < source_length && !relex(start_offset, start_line))
+    {
+        // Keep the old tokens; the change stays pending and is re-lexed together with the next edit
+        token_count = old_count;
+        forget_identifiers(kept);
+        restore_declarations(0, 0);
+        return 0;
+    }
+
+    int new_count = token_count - list_end;
+    token_count = old_count;
+    int old_end = sync_index >= 0 ? sync_index + 1 : old_count; // Old tokens [first, old_end) are replaced
+    int shift = new_count - (old_end - first);                  // Change of the number of tokens
+
+    // An include depends on what was included before, and was checked against the old tokens still in the list;
+    // so do limits that a partial update cannot keep to
+    int tail_declarations = 0;
+    for (int i = 0; i < saved_count; i++)
+        tail_declarations += saved_tokens[i] >= old_end;
+    int modules = has_module(token_at(first), old_end - first) || has_module(&token_list[list_end], new_count);
+    if (old_count > 0 && (modules || declared_count + tail_declarations > MAX_IDENTIFIERS ||
+                          missing_count + saved_count + undeclared_count > MAX_MISSING_NAMES))
+    {
+        return check_source_from_scratch();
+    }
+
+    // Everything that changed since the program was last valid, with its braces back then
+    int region = add_dirty_region(first, old_end, new_count);
+    count_names(first, old_end, -1);
+
+    // The new tokens take the place of the replaced ones at the start of the gap, and the tail lags behind by the
+    // change as well. Only when they do not fit is the tail moved, to leave room for many more edits.
+    int room = gap_length + old_end - first;
+    if (new_count <= room)
+    {
+        memcpy(&token_list[first], &token_list[list_end], new_count * sizeof(Token));
+        gap_length = room - new_count;
+    }
+    else
+    {
+        if (new_count > splice_capacity)
+        {
+            splice_capacity = new_count * 2;
+            splice_buffer = realloc(splice_buffer, splice_capacity * sizeof(Token));
+        }
+        memcpy(splice_buffer, &token_list[list_end], new_count * sizeof(Token));
+        int spare = old_count / 16 + 256;
+        reserve_tokens(first + new_count + spare + old_count - old_end);
+        memmove(&token_list[first + new_count + spare], &token_list[old_end + gap_length],
+                (old_count - old_end) * sizeof(Token));
+        memcpy(&token_list[first], splice_buffer, new_count * sizeof(Token));
+        gap_length = spare;
+    }
+    shift_offset += delta;
+    shift_lines += pending_lines;
+    token_count = old_count + shift;
+    shift_from = first + new_count;
+    pending_start = -1;
+    count_names(first, first + new_count, 1);
+
+    // The lexer declared the new declarations at the end of the list; the ones after the change follow them
+    for (int i = kept; i < declared_count; i++)
+        declared_tokens[i] += first - list_end;
+    for (int m = 0; m < missing_count; m++)
+    {
+        if (missing_from[m] >= old_end)
+            missing_from[m] += shift;
+        else if (missing_from[m] > first)
+            missing_from[m] = first;
+    }
+    for (int i = 0; i < saved_count && saved_tokens[i] < old_end; i++)
+    {
+        if (!is_declared(saved_names[i]))
+            add_missing_name(saved_names[i], first + new_count); // Removed, and not declared again before the tail
+    }
+    restore_declarations(old_end, shift);
+    for (int i = 0; i < undeclared_count; i++)
+        add_missing_name(undeclared_names[i], first + undeclared_tokens[i]);
+
+    int identifiers_valid = check_missing_names();
+    int syntax_valid = check_syntax(limit_dirty_regions(region));
+    return identifiers_valid && syntax_valid;
+}
+
+// Function to tokenize and parse the whole source from scratch
+int check_source_from_scratch()
+{
+    token_count = 0;
+    forget_identifiers(0);
+    shift_from = 0;
+    shift_offset = 0;
+    shift_lines = 0;
+    gap_length = 0;
+    dirty_count = 0;
+    missing_count = 0;
+    memset(name_counts, 0, sizeof(name_counts));
+    name_slots = 0;
+
+    pending_start = 0;
+    pending_old_end = 0;
+    pending_new_end = source_length;
+    pending_lines = 0;
+    return relex_pending();
+}
+
+// Function to load a complete source text
+int load_source(const char *text)
+{
+    replace_text(0, source_length, text, strlen(text));
+    return check_source_from_scratch();
+}
+
+// Function to apply one edit to the source and update the tokens and syntax check incrementally
+int apply_edit(int offset, int removed_length, const char *inserted)
+{
+    if (offset < 0 || removed_length < 0 || offset + removed_length > source_length)
+    {
+        fprintf(stderr, "[ERROR]: Edit is outside of the source text.\n");
+        return 0;
+    }
+
+    int inserted_length = strlen(inserted);
+    int lines = count_lines(inserted, inserted_length) - count_lines(source_text + offset, removed_length);
+
+    replace_text(offset, removed_length, inserted, inserted_length);
+    add_pending_edit(offset, offset + removed_length, offset + inserted_length, lines);
+    return relex_pending();
+}
+
+// Function to get the edited source text
+const char *get_source_text()
+{
+    return source_text ? source_text : "";
+}
+
+// Most edits of the edit check waiting to be undone
+#define EDIT_UNDO_DEPTH 4
+
+// Distance in characters from the last edit within which most edits of the edit check fall
+#define EDIT_NEARBY 200
+
+// Pieces of text the edit check inserts, besides copies of parts of the script itself
+const char *edit_fragments[] = {";", "{", "}", " ", "\n", "*", "\"", "1", "x", ":=", " := 2;", "+= 1;", "number ",
+                                "repeat 3 times ", "write ", " and ", "newline", "{\n", "}\n", NULL};
+
+// Function to get the next number of the edit check's deterministic random sequence (xorshift, which reaches every
+// offset of a large script, unlike the 15 bits rand() may give)
+unsigned edit_random(unsigned *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Function to send stderr to the null device, returning a descriptor to restore it from
+int silence_stderr()
+{
+    fflush(stderr);
+#ifdef _WIN32
+    int saved = _dup(2);
+    FILE *null = fopen("NUL", "w");
+    if (null)
+    {
+        _dup2(_fileno(null), 2);
+        fclose(null);
+    }
+#else
+    int saved = dup(2);
+    FILE *null = fopen("/dev/null", "w");
+    if (null)
+    {
+        dup2(fileno(null), 2);
+        fclose(null);
+    }
+#endif
+    return saved;
+}
+
+// Function to send stderr where it went before silence_stderr()
+void restore_stderr(int saved)
+{
+    fflush(stderr);
+#ifdef _WIN32
+    _dup2(saved, 2);
+    _close(saved);
+#else
+    dup2(saved, 2);
+    close(saved);
+#endif
+}
+
+// Function to tokenize and parse the edited source the way a normal run does. Returns 1 if it is valid.
+int check_full_source()
+{
+    jmp_buf recovery;
+    token_count = 0;
+    forget_identifiers(0);
+    if (source_length == 0)
+        return 1;
+
+    FILE *in = open_string_stream(source_text);
+    if (!in)
+        return 0;
+    if (setjmp(recovery) != 0)
+    {
+        error_recovery = NULL;
+        fclose(in);
+        return 0;
+    }
+    error_recovery = &recovery;
+    tokenize(in, NULL);
+    error_recovery = NULL;
+    fclose(in);
+    return parse_all_tokens();
+}
+
+// Function to apply random edits to a script, checking after each one that the incremental update agrees with a full
+// re-lex and re-parse of the edited text
+int run_edit_check(const char *source_file, int edits)
+{
+    char *text = read_text_file(source_file);
+    if (!text)
+    {
+        fprintf(stderr, "[ERROR]: Could not read '%s'.\n", source_file);
+        return 1;
+    }
+
+    // The incremental state is put aside while the full check uses the lexer
+    Token *kept_tokens = NULL;
+    int kept_capacity = 0;
+    static char kept_names[MAX_IDENTIFIERS][NAME_SIZE];
+    int kept_declared[MAX_IDENTIFIERS];
+
+    // The edits not undone yet, the last one first. Most random edits break the program; undoing them (half of the
+    // edits, and always once EDIT_UNDO_DEPTH are waiting) repairs it again.
+    char undo_text[EDIT_UNDO_DEPTH][16];
+    int undo_offset[EDIT_UNDO_DEPTH], undo_length[EDIT_UNDO_DEPTH];
+    int undo_count = 0;
+
+    // Time of each edit, for the medians: a few edits, like an opened comment that now runs to the end, re-lex most of
+    // the script and would hide the typical time in an average
+    double *incremental_times = malloc(edits * sizeof(double));
+    double *full_times = malloc(edits * sizeof(double));
+    if (!incremental_times || !full_times)
+    {
+        fprintf(stderr, "[ERROR]: Out of memory for %d edits.\n", edits);
+        exit(1);
+    }
+
+    unsigned state = 12345;
+    int last_offset = 0;
+    int checked = 0, valid_count = 0, mismatches = 0;
+    double incremental_seconds = 0, full_seconds = 0;
+
+    int silenced = silence_stderr();
+    load_source(text);
+    free(text);
+
+    for (int e = 1; e <= edits && mismatches == 0; e++)
+    {
+        checked = e;
+        char inserted[32];
+        int offset, removed;
+        if (undo_count == EDIT_UNDO_DEPTH || (undo_count > 0 && edit_random(&state) % 2 == 0))
+        {
+            undo_count--;
+            offset = undo_offset[undo_count];
+            removed = undo_length[undo_count];
+            strcpy(inserted, undo_text[undo_count]);
+        }
+        else
+        {
+            // Like in an editor, most edits are near the last one, and now and then the edit jumps elsewhere
+            if (edit_random(&state) % 4 == 0)
+                offset = edit_random(&state) % (source_length + 1);
+            else
+                offset = last_offset - EDIT_NEARBY + (int)(edit_random(&state) % (2 * EDIT_NEARBY + 1));
+            if (offset < 0)
+                offset = 0;
+            if (offset > source_length)
+                offset = source_length;
+            last_offset = offset;
+            removed = edit_random(&state) % 8;
+            if (removed > source_length - offset)
+                removed = source_length - offset;
+
+            if (edit_random(&state) % 3 == 0)
+            {
+                // A copy of another part of the script, so the names in it are declared ones
+                int from = edit_random(&state) % (source_length + 1);
+                int length = edit_random(&state) % 16;
+                if (length > source_length - from)
+                    length = source_length - from;
+                memcpy(inserted, source_text + from, length);
+                inserted[length] = '\0';
+            }
+            else
+            {
+                int count = 0;
+                while (edit_fragments[count])
+                    count++;
+                strcpy(inserted, edit_fragments[edit_random(&state) % count]);
+            }
+
+            memcpy(undo_text[undo_count], source_text + offset, removed);
+            undo_text[undo_count][removed] = '\0';
+            undo_offset[undo_count] = offset;
+            undo_length[undo_count++] = strlen(inserted);
+        }
+
+        double start = bench_seconds();
+        int valid = apply_edit(offset, removed, inserted);
+        incremental_times[e - 1] = bench_seconds() - start;
+        incremental_seconds += incremental_times[e - 1];
+        valid_count += valid;
+
+        // The token list is kept as it is, with its gap, so the next edit finds it unchanged
+        int count = token_count, declared = declared_count, kept_length = token_count + gap_length;
+        if (kept_length > kept_capacity)
+        {
+            kept_capacity = kept_length * 2;
+            kept_tokens = realloc(kept_tokens, kept_capacity * sizeof(Token));
+        }
+        memcpy(kept_tokens, token_list, kept_length * sizeof(Token));
+        for (int i = 0; i < declared; i++)
+        {
+            strcpy(kept_names[i], declared_identifiers[i]);
+            kept_declared[i] = declared_tokens[i];
+        }
+
+        start = bench_seconds();
+        int full_valid = check_full_source();
+        full_times[e - 1] = bench_seconds() - start;
+        full_seconds += full_times[e - 1];
+
+        // Both must agree on the validity, and for a valid program on every token and declaration
+        const char *difference = NULL;
+        if (valid != full_valid)
+            difference =
+                valid ? "the incremental update accepts the program" : "the incremental update rejects the program";
+        else if (valid && (count != token_count || declared != declared_count))
+            difference = "the number of tokens or declarations differs";
+        for (int i = 0; valid && !difference && i < count; i++)
+        {
+            int lag = i >= shift_from;
+            const Token *a = &kept_tokens[i + lag * gap_length], *b = &token_list[i];
+            int in_module = i > 0 && i + 1 < count && token_list[i - 1].offset == b->offset &&
+                            token_list[i + 1].offset == b->offset;
+            if (a->type != b->type || strcmp(a->value, b->value) != 0 || a->length != b->length ||
+                a->offset + lag * shift_offset != b->offset || a->line + lag * !in_module * shift_lines != b->line)
+                difference = "a token differs";
+        }
+        for (int i = 0; valid && !difference && i < declared; i++)
+        {
+            if (strcmp(kept_names[i], declared_identifiers[i]) != 0)
+                difference = "a declaration differs";
+        }
+
+        // Put the incremental state back
+        reserve_tokens(kept_length);
+        memcpy(token_list, kept_tokens, kept_length * sizeof(Token));
+        token_count = count;
+        forget_identifiers(0);
+        for (int i = 0; i < declared; i++)
+        {
+            declare_identifier(kept_names[i]);
+            declared_tokens[i] = kept_declared[i];
+        }
+
+        if (difference)
+        {
+            restore_stderr(silenced);
+            fprintf(stderr, "[ERROR]: Edit %d (%d characters at offset %d replaced by \"%s\"): %s.\n", e, removed, offset,
+                    inserted, difference);
+            silenced = silence_stderr();
+            mismatches++;
+        }
+    }
+    restore_stderr(silenced);
+    free(kept_tokens);
+
+    printf("%d edits checked against a full re-lex and re-parse: %d left the program valid, %d mismatches.\n", checked,
+           valid_count, mismatches);
+    printf("Incremental update: %.1f us per edit (median %.1f us), full re-lex and re-parse: %.1f us per edit (median "
+           "%.1f us).\n",
+           incremental_seconds * 1e6 / checked, median(incremental_times, checked) * 1e6, full_seconds * 1e6 / checked,
+           median(full_times, checked) * 1e6);
+    free(incremental_times);
+    free(full_times);
+    return mismatches;
+}
@@ -0,0 +1,26 @@
+// incremental.h
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+// Loads a complete source text, tokenizing and parsing it from scratch. Returns 1 if the program is valid, 0 otherwise.
+int load_source(const char *text);
+
+// Replaces removed_length characters at offset with the inserted text. Only the statements touched by the edit are
+// re-lexed and re-parsed, and the tokens before and after them are reused: the token list keeps a gap at the last
+// edit, and the tokens after it lag behind in offset and line, so only the tokens between this edit and the last one
+// move. Apart from moving the source text itself, the work depends on the edit rather than on the size of the source.
+// After an error, edits near it re-check the failed part along with their own.
+// Returns 1 if the program is valid after the edit, 0 otherwise. Error messages are reported on stderr as usual.
+int apply_edit(int offset, int removed_length, const char *inserted);
+
+// Brings the offset and line of every token up to date and closes the gap, for using token_list after apply_edit()
+void update_token_positions();
+
+// Returns the source text with all edits applied so far
+const char *get_source_text();
+
+// Applies the given number of random edits to a script, comparing the result of each incremental update with a full
+// re-lex and re-parse of the edited text, and prints how long both took. Returns the number of mismatches.
+int run_edit_check(const char *source_file, int edits);
+
+#endif
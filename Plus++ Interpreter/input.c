@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include "input.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Digits are checked 16 bytes at a time with SSE2, which every x86-64 processor has
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define INPUT_SSE2
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+// Bytes the reader needs in view to see a whole number: sign, digits and the byte after them
+#define MAX_INPUT_WORD (MAX_INPUT_DIGITS + 2)
+
+const char *input_file = NULL;
+int input_stdin_allowed = 1;
+long long input_bytes = 0;
+long long input_numbers = 0;
+
+// File descriptor of the input, -1 while it is not open
+int input_fd = -1;
+
+// Input in view of the reader: the whole mapped file, or the part of it that is in input_buffer
+const char *input_data = NULL;
+size_t input_length = 0;
+size_t input_position = 0; // Next byte to look at
+long long input_base = 0;  // Position of input_data[0] in the input
+int input_complete = 0;    // 1 once input_data holds everything up to the end of the input
+
+// Mapped input file, NULL if the input is read into input_buffer
+char *input_mapping = NULL;
+size_t input_mapping_size = 0;
+
+// Buffer for input that is read rather than mapped
+char input_buffer[INPUT_BUFFER_SIZE];
+
+// Text returned by input_error()
+char input_message[600];
+
+// Function to check for the whitespace that separates numbers
+int is_input_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Function to open the input file, or stdin. Returns 0 if it cannot be opened.
+int input_open()
+{
+    if (input_file)
+    {
+#ifdef _WIN32
+        input_fd = _open(input_file, _O_RDONLY | _O_BINARY);
+#else
+        input_fd = open(input_file, O_RDONLY | O_BINARY);
+#endif
+        if (input_fd < 0)
+            return 0;
+    }
+    else if (input_stdin_allowed)
+    {
+        input_fd = 0;
+    }
+    else
+    {
+        return 0;
+    }
+
+    input_data = input_buffer;
+    input_length = 0;
+    input_position = 0;
+    input_base = 0;
+    input_complete = 0;
+
+#ifndef _WIN32
+    // A regular file is mapped as a whole, so numbers are converted where the kernel keeps the file and no bytes
+    // are copied. stdin may start in the middle of the file if something read from it before.
+    struct stat st;
+    off_t start = lseek(input_fd, 0, SEEK_CUR);
+    if (fstat(input_fd, &st) == 0 && S_ISREG(st.st_mode) && start >= 0 && st.st_size > start)
+    {
+        void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, input_fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+#ifdef MADV_SEQUENTIAL
+            madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL); // Read ahead, and drop the pages already parsed
+#endif
+            input_mapping = mapping;
+            input_mapping_size = (size_t)st.st_size;
+            input_data = input_mapping;
+            input_length = input_mapping_size;
+            input_position = (size_t)start;
+            input_base = -(long long)start;
+            input_complete = 1;
+        }
+    }
+#endif
+    return 1;
+}
+
+// Function to read more input into the buffer, keeping the bytes not looked at yet. Reads until at least want bytes
+// are in view or the input ends.
+void input_refill(size_t want)
+{
+    size_t kept = input_length - input_position;
+    memmove(input_buffer, input_buffer + input_position, kept);
+    input_base += input_position;
+    input_length = kept;
+    input_position = 0;
+
+    while (input_length < want && !input_complete)
+    {
+#ifdef _WIN32
+        long long n = _read(input_fd, input_buffer + input_length, (unsigned)(INPUT_BUFFER_SIZE - input_length));
+#else
+        long long n = read(input_fd, input_buffer + input_length, INPUT_BUFFER_SIZE - input_length);
+#endif
+        if (n <= 0)
+            input_complete = 1;
+        else
+            input_length += (size_t)n;
+    }
+}
+
+// Function to count the digits at the start of s, looking at no more than n bytes
+size_t count_digits(const char *s, size_t n)
+{
+    size_t i = 0;
+#ifdef INPUT_SSE2
+    // A byte is a digit if subtracting '0' leaves at most 9 as an unsigned number; the first byte that is not ends the run
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(s + i)), zero);
+        unsigned digits = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        if (digits != 0xFFFF)
+            return i + (size_t)__builtin_ctz(~digits);
+    }
+#endif
+    while (i < n && s[i] >= '0' && s[i] <= '9')
+        i++;
+    return i;
+}
+
+// Function to read the next number of the input
+int input_read(BigInt *value)
+{
+    if (input_fd < 0 && !input_open())
+        return INPUT_NO_SOURCE;
+
+    // Skip the whitespace before the number
+    while (1)
+    {
+        while (input_position < input_length && is_input_space(input_data[input_position]))
+            input_position++;
+        if (input_position < input_length || input_complete)
+            break;
+        input_refill(1);
+    }
+    if (input_position == input_length)
+        return INPUT_END;
+
+    // Make sure a whole number is in view, so it is converted straight from the buffer or mapping
+    if (input_length - input_position < MAX_INPUT_WORD && !input_complete)
+        input_refill(MAX_INPUT_WORD);
+
+    const char *p = input_data + input_position;
+    size_t available = input_length - input_position;
+    size_t sign = *p == '-' || *p == '+';
+    size_t digits = count_digits(p + sign, available - sign < MAX_INPUT_DIGITS + 1 ? available - sign : MAX_INPUT_DIGITS + 1);
+    size_t end = sign + digits;
+    if (digits > MAX_INPUT_DIGITS)
+        return INPUT_TOO_LONG;
+    if (digits == 0 || (end < available && !is_input_space(p[end])))
+        return INPUT_INVALID;
+
+    bigint_from_digits(value, p + sign, digits, *p == '-');
+    input_position += end;
+    input_bytes = input_base + (long long)input_position;
+    input_numbers++;
+    return INPUT_OK;
+}
+
+// Function to describe why a read failed
+const char *input_error(int status)
+{
+    long long position = input_base + (long long)input_position;
+    switch (status)
+    {
+    case INPUT_END:
+        snprintf(input_message, sizeof(input_message), "No number left in the input (%lld numbers read).", input_numbers);
+        break;
+    case INPUT_INVALID:
+        snprintf(input_message, sizeof(input_message), "Input at byte %lld is not a decimal integer.", position);
+        break;
+    case INPUT_TOO_LONG:
+        snprintf(input_message, sizeof(input_message), "Number at input byte %lld exceeds %d digits.", position, MAX_INPUT_DIGITS);
+        break;
+    case INPUT_NO_SOURCE:
+        if (input_file)
+            snprintf(input_message, sizeof(input_message), "Could not open input file '%.500s'.", input_file);
+        else
+            snprintf(input_message, sizeof(input_message), "No input: stdin is in use, give the input with --input FILE.");
+        break;
+    default:
+        snprintf(input_message, sizeof(input_message), "Unknown input error.");
+        break;
+    }
+    return input_message;
+}
+
+// Function to skip bytes of the input
+int input_skip(long long bytes)
+{
+    if (input_fd < 0 && !input_open())
+        return 0;
+
+    while (bytes > 0)
+    {
+        if (input_position == input_length)
+        {
+            if (input_complete)
+                return 0;
+            input_refill(1);
+            continue;
+        }
+        size_t step = input_length - input_position;
+        if ((long long)step > bytes)
+            step = (size_t)bytes;
+        input_position += step;
+        bytes -= (long long)step;
+    }
+    input_bytes = input_base + (long long)input_position;
+    return 1;
+}
+
+// Function to close the input
+void input_close()
+{
+#ifndef _WIN32
+    if (input_mapping)
+        munmap(input_mapping, input_mapping_size);
+#endif
+    input_mapping = NULL;
+    if (input_file && input_fd >= 0)
+    {
+#ifdef _WIN32
+        _close(input_fd);
+#else
+        close(input_fd);
+#endif
+    }
+    input_fd = -1;
+    input_bytes = 0;
+}
@@ -0,0 +1,43 @@
+// input.h
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "bigint.h"
+
+// Size of the buffer input is read into when it cannot be mapped (pipes, terminals)
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+// Most digits a number in the input may have, like an integer constant in the source
+#define MAX_INPUT_DIGITS 100
+
+// Results of input_read()
+#define INPUT_OK 0
+#define INPUT_END 1       // No number left
+#define INPUT_INVALID 2   // The next word is not a decimal integer
+#define INPUT_TOO_LONG 3  // The next number has more than MAX_INPUT_DIGITS digits
+#define INPUT_NO_SOURCE 4 // The input file cannot be opened, or stdin is not available for input
+
+// File the read statements take their numbers from (--input), NULL for stdin
+extern const char *input_file;
+
+// 0 while stdin holds something else than input, e.g. the statements of the REPL
+extern int input_stdin_allowed;
+
+// Bytes of input consumed and numbers read so far
+extern long long input_bytes;
+extern long long input_numbers;
+
+// Reads the next whitespace-separated decimal integer (with an optional sign) into value. The input is opened on
+// first use: a regular file is mapped into memory, anything else is read in INPUT_BUFFER_SIZE blocks.
+int input_read(BigInt *value);
+
+// Returns the message for a result of input_read() other than INPUT_OK
+const char *input_error(int status);
+
+// Skips the first bytes of the input, to continue where an earlier run stopped. Returns 0 if the input is shorter.
+int input_skip(long long bytes);
+
+// Closes the input, so the next read starts again at the beginning of the input file
+void input_close();
+
+#endif
@@ -2,6 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include "lexer.h"
+#include "error.h"
+#include "output.h"
+#include "interpreter.h"
+#include "options.h"
+#include "checkpoint.h"
+#include "compiler.h"
+#include "params.h"
+#include "regions.h"
+#include "profile.h"
+#include "trace.h"
+#include "metrics.h"
+#include "status.h"
+#include "memory.h"
+#include "input.h"
 
 // External variables and functions declared in lexer/parser
 extern int current;
@@ -9,23 +23,24 @@ extern Token *peek();
 extern Token *advance();
 extern int match(TokenType type, const char *val);
 
-#define MAX_VARS 100
-
-// A simple structure to represent a variable in the program
-typedef struct
-{
-    char name[64];
-    long long value;
-    int initialized;
-} Variable;
-
 // A table to store all declared variables
 Variable var_table[MAX_VARS];
 int var_count = 0;
 
-// Declaration of the function used to interpret a single statement
-extern Token token_list[MAX_TOKENS];
-extern int token_count;
+// Stack of the blocks and repeat loops that are currently executing
+Frame *frame_stack = NULL;
+int frame_depth = 0;
+int frame_capacity = 0;
+
+// For every '{' token, the index of its matching '}' token
+int *block_end = NULL;
+
+// For every repeat body (by index of its first token), the iterations run so far and its compiled code (NULL until it is hot)
+int *body_iterations = NULL;
+CompiledBody **compiled_bodies = NULL;
+
+// Number of tokens the tables above have entries for
+int token_table_size = 0;
 
 // Forward declaration
 void interpret_statement(void);
@@ -56,15 +71,18 @@ void declare_var(const char *name, int line)
     if (find_var(name) != -1)
     {
         fprintf(stderr, "[ERROR] (line %d): Variable '%s' already declared.\n", line, name);
-        exit(1);
+        error_exit();
     }
     if (var_count >= MAX_VARS)
     {
         fprintf(stderr, "[ERROR]: Too many variables.\n");
-        exit(1);
+        error_exit();
     }
     strcpy(var_table[var_count].name, name);
-    var_table[var_count].value = 0;
+    bigint_set_ll(variable_value(var_count), 0); // Reuses the limbs of a variable that used this slot before
+    const BigInt *bound = parameter_count > 0 ? declare_parameter(name) : NULL;
+    if (bound)
+        bigint_copy(&var_table[var_count].value, bound); // Bound from the command line
     var_table[var_count].initialized = 1;
     var_count++;
 }
@@ -75,16 +93,20 @@ void check_var_exists(const char *name, int line)
     if (find_var(name) == -1)
     {
         fprintf(stderr, "[ERROR] (line %d): Variable '%s' is not declared.\n", line, name);
-        exit(1);
+        error_exit();
     }
 }
 
-// Function to get the numeric value of a token (either constant or variable)
-long long get_value(Token *t)
+// Value of the last constant read by get_value()
+BigInt constant_value;
+
+// Function to get the numeric value of a token (either constant or variable). A constant's value stays valid until the next call.
+const BigInt *get_value(Token *t)
 {
     if (t->type == TOKEN_INTCONST)
     {
-        return atoll(t->value);
+        bigint_parse(&constant_value, t->value);
+        return &constant_value;
     }
     else if (t->type == TOKEN_IDENTIFIER)
     {
@@ -92,14 +114,14 @@ long long get_value(Token *t)
         if (idx == -1)
         {
             fprintf(stderr, "[ERROR] (line %d): Variable '%s' not declared.\n", t->line, t->value);
-            exit(1);
+            error_exit();
         }
-        return var_table[idx].value;
+        return variable_value(idx);
     }
     else
     {
         fprintf(stderr, "ERROR (line %d): Invalid value '%s'.\n", t->line, t->value);
-        exit(1);
+        error_exit();
     }
 }
 
@@ -110,30 +132,163 @@ void set_variable(const char *name, long long new_value)
     if (idx == -1)
     {
         fprintf(stderr, "[ERROR]: Variable '%s' not declared.\n", name);
-        exit(1);
+        error_exit();
     }
-    var_table[idx].value = new_value;
+    bigint_set_ll(variable_value(idx), new_value);
 }
 
-// Function to interpret a block of statements enclosed by { }
-void interpret_block()
+// Function to get the value of a variable, propagating the carries of earlier additions first
+BigInt *variable_value(int idx)
 {
-    if (!match(TOKEN_OPENBLOCK, NULL))
+    if (var_table[idx].carries.pending)
+        bigint_settle(&var_table[idx].value, &var_table[idx].carries);
+    return &var_table[idx].value;
+}
+
+// Function to add to a variable. A loop summing wide values into a variable only adds limbs side by side; the
+// carries are propagated once, when the variable is read.
+void accumulate(int idx, const BigInt *value, int negate)
+{
+    Variable *v = &var_table[idx];
+    if ((v->carries.pending || value->length >= CARRY_SAVE_MIN_LIMBS) && bigint_add_deferred(&v->value, &v->carries, value, negate))
+        return; // Counters and other small sums skip straight to the normal addition
+
+    bigint_settle(&v->value, &v->carries);
+    if (negate)
+        bigint_sub(&v->value, value);
+    else
+        bigint_add(&v->value, value);
+}
+
+// Function to stop with a runtime error if an arithmetic operation failed
+void check_arithmetic(int status, int line)
+{
+    if (status != BIGINT_OK)
     {
-        fprintf(stderr, "[ERROR]: Expected '{'\n");
-        exit(1);
+        fprintf(stderr, "[ERROR] (line %d): %s\n", line, bigint_error(status));
+        error_exit();
+    }
+}
+
+// Function to push a new frame onto the execution stack
+void push_frame(int count_token, int body_start, int body_end, long long remaining)
+{
+    if (frame_depth == frame_capacity)
+        reserve_frames(frame_depth + 1);
+    Frame *f = &frame_stack[frame_depth++];
+    f->count_token = count_token;
+    f->body_start = body_start;
+    f->body_end = body_end;
+    f->remaining = remaining;
+}
+
+// Function to make room for at least count frames
+void reserve_frames(int count)
+{
+    if (count <= frame_capacity)
+        return;
+    int capacity = frame_capacity ? frame_capacity : 64;
+    while (capacity < count)
+        capacity *= 2;
+    frame_stack = memory_realloc(frame_stack, frame_capacity * sizeof(Frame), capacity * sizeof(Frame));
+    frame_capacity = capacity;
+}
+
+// Function to give the tables kept per token an entry for every token; new entries start empty
+void size_token_tables()
+{
+    int size = token_count + 1; // The end of the program can be a loop body start too
+    if (size <= token_table_size)
+        return;
+    block_end = memory_realloc(block_end, token_table_size * sizeof(int), size * sizeof(int));
+    body_iterations = memory_realloc(body_iterations, token_table_size * sizeof(int), size * sizeof(int));
+    compiled_bodies = memory_realloc(compiled_bodies, token_table_size * sizeof(CompiledBody *), size * sizeof(CompiledBody *));
+    for (int i = token_table_size; i < size; i++)
+    {
+        body_iterations[i] = 0;
+        compiled_bodies[i] = NULL;
     }
+    token_table_size = size;
+}
 
-    while (peek() && peek()->type != TOKEN_CLOSEBLOCK)
+// Function to find the matching '}' of every '{' once, so entering a block does not need to scan for its end
+void find_block_ends()
+{
+    size_token_tables();
+
+    int *open = memory_alloc((token_count + 1) * sizeof(int));
+    int depth = 0;
+
+    for (int i = 0; i < token_count; i++)
     {
-        interpret_statement();
+        if (token_list[i].type == TOKEN_OPENBLOCK)
+        {
+            open[depth++] = i;
+        }
+        else if (token_list[i].type == TOKEN_CLOSEBLOCK && depth > 0)
+        {
+            block_end[open[--depth]] = i;
+        }
+    }
+    memory_free(open, (token_count + 1) * sizeof(int));
+}
+
+// Function to drop the compiled loop bodies and iteration counts, which belong to the previous token list
+void forget_compiled_bodies()
+{
+    for (int i = 0; i < token_table_size; i++)
+    {
+        free_compiled(compiled_bodies[i]);
+        compiled_bodies[i] = NULL;
+        body_iterations[i] = 0;
+    }
+}
+
+// Function to get the index just past the statement starting at the given token
+int statement_end(int start)
+{
+    if (token_list[start].type == TOKEN_OPENBLOCK)
+        return block_end[start] + 1;
+
+    int i = start;
+    while (i < token_count && token_list[i].type != TOKEN_ENDOFLINE)
+        i++;
+    return i + 1; // Include the semicolon
+}
+
+// Function to check whether the program reads input
+int program_reads_input()
+{
+    for (int i = 0; i < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_KEYWORD && strcmp(token_list[i].value, "read") == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Function to check whether the program declares a variable
+int program_declares(const char *name)
+{
+    for (int i = 0; i + 1 < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_KEYWORD && strcmp(token_list[i].value, "number") == 0 &&
+            strcmp(token_list[i + 1].value, name) == 0)
+            return 1;
     }
+    return 0;
+}
 
-    if (!match(TOKEN_CLOSEBLOCK, NULL))
+// Function to enter a block of statements enclosed by { }. Its statements are then executed by run_program().
+void interpret_block()
+{
+    if (!match(TOKEN_OPENBLOCK, NULL))
     {
-        fprintf(stderr, "[ERROR]: Expected '}' to close block.\n");
-        exit(1);
+        fprintf(stderr, "[ERROR]: Expected '{'\n");
+        error_exit();
     }
+
+    push_frame(-1, current, block_end[current - 1], 0);
 }
 
 // Function to interpret a write statement: write strings, variables, constants, newline
@@ -164,19 +319,19 @@ void interpret_write()
             // If it's a string constant, print it as-is
             if (t->type == TOKEN_STRINGCONST)
             {
-                printf("%s", t->value);
+                output_string(t->value);
                 advance();
             }
             // If it's the keyword "newline", print a newline character
             else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "newline") == 0)
             {
-                printf("\n");
+                output_string("\n");
                 advance();
             }
             // If it's a number constant or a variable, print its value
             else if (t->type == TOKEN_INTCONST || t->type == TOKEN_IDENTIFIER)
             {
-                printf("%lld", get_value(t));
+                output_bigint(get_value(t));
                 advance();
             }
             // If none of the above, end the write statement
@@ -193,82 +348,112 @@ void interpret_write()
     if (!match(TOKEN_ENDOFLINE, NULL))
     {
         fprintf(stderr, "[ERROR]: Expected ';' at end of write statement.\n");
-        exit(1);
+        error_exit();
+    }
+}
+
+// Function to stop with a runtime error if reading a number from the input failed
+void check_input(int status, int line)
+{
+    if (status != INPUT_OK)
+    {
+        fprintf(stderr, "[ERROR] (line %d): %s\n", line, input_error(status));
+        error_exit();
+    }
+}
+
+// Function to interpret a read statement: the next number of the input goes into the variable
+void interpret_read()
+{
+    advance();             // Skip the "read" keyword
+    Token *id = advance(); // The variable that receives the number
+
+    int idx = find_var(id->value);
+    check_var_exists(id->value, id->line);
+    check_input(input_read(variable_value(idx)), id->line);
+
+    if (!match(TOKEN_ENDOFLINE, NULL))
+    {
+        fprintf(stderr, "[ERROR]: Expected ';' at end of read statement.\n");
+        error_exit();
     }
 }
 
-// Function to interpret a repeat loop with a count and a block or single statement
+// Function to start a repeat loop with a count and a block or single statement
 void interpret_repeat()
 {
     advance(); // Skip the "repeat" keyword
 
     // Get the repeat count (either a number or a variable)
+    int count_index = current;
     Token *count_tok = advance();
-    long long count = get_value(count_tok);
+    long long count = bigint_clamp(get_value(count_tok)); // Counts beyond the range of long long never finish anyway
 
     // Expect the keyword "times" after the repeat count
     if (!match(TOKEN_KEYWORD, "times"))
     {
         fprintf(stderr, "[ERROR]: Expected 'times' after repeat.\n");
-        exit(1);
+        error_exit();
     }
 
-    // Decide whether to repeat a block { } or a single statement
-    if (peek()->type == TOKEN_OPENBLOCK)
-    {
-        // Repeating a block of code
-        int block_start = current; // Save position to reset for each iteration
-
-        while (count >= 1)
-        {
-            current = block_start; // Reset to start of block
-            interpret_block();     // Execute the block
-
-            // If repeat count is a variable, update its value
-            if (count_tok->type == TOKEN_IDENTIFIER)
-            {
-                set_variable(count_tok->value, count - 1);
-                count = get_value(count_tok); // Get updated value
-            }
-            else
-            {
-                count--;
-            }
-        }
+    // The body is either a block { } or a single statement
+    int body_start = current;
+    int body_end = statement_end(body_start);
 
-        // After loop, ensure variable (if used) is set to 0
+    if (count >= 1)
+    {
+        // Run the first iteration; run_program() starts the next ones when the body ends
+        push_frame(count_index, body_start, body_end, count);
+    }
+    else
+    {
+        // Nothing to repeat: skip the body and leave the count variable (if used) at 0
         if (count_tok->type == TOKEN_IDENTIFIER)
         {
             set_variable(count_tok->value, 0);
         }
+        current = body_end;
     }
-    else
+}
+
+// Function to handle reaching the end of the innermost block or loop body
+void end_frame()
+{
+    Frame *f = &frame_stack[frame_depth - 1];
+
+    // End of a block: consume the '}' and leave it
+    if (f->count_token < 0)
     {
-        // Repeating a single statement
-        int statement_start = current; // Save position to reset for each iteration
+        current++;
+        frame_depth--;
+        return;
+    }
 
-        while (count >= 1)
-        {
-            current = statement_start; // Reset to start of statement
-            interpret_statement();     // Execute the statement
+    // End of a loop body: one iteration less to go
+    Token *count_tok = &token_list[f->count_token];
+    f->remaining--;
+    loop_iterations++;
 
-            // Update repeat count if it's a variable
-            if (count_tok->type == TOKEN_IDENTIFIER)
-            {
-                set_variable(count_tok->value, count - 1);
-                count = get_value(count_tok); // Refresh value
-            }
-            else
-            {
-                count--;
-            }
-        }
+    // Once a body has run often enough, compile it so the next iterations skip token dispatch and variable lookups
+    if (++body_iterations[f->body_start] == options.compile_threshold)
+    {
+        compiled_bodies[f->body_start] = compile_body(f->body_start, f->body_end);
+    }
 
-        // Set repeat variable to 0 at the end
-        if (count_tok->type == TOKEN_IDENTIFIER)
-        {
-            set_variable(count_tok->value, 0);
-        }
+    // If repeat count is a variable, it always holds the number of iterations left
+    if (count_tok->type == TOKEN_IDENTIFIER)
+    {
+        set_variable(count_tok->value, f->remaining);
+    }
+
+    if (f->remaining >= 1)
+    {
+        current = f->body_start; // Start the next iteration
+    }
+    else
+    {
+        current = f->body_end; // Loop finished, continue after the body
+        frame_depth--;
     }
 }
 
@@ -292,7 +477,7 @@ void interpret_statement()
             {
                 // Error if identifier is missing or invalid
                 fprintf(stderr, "[ERROR]: Expected identifier after 'number'\n");
-                exit(1);
+                error_exit();
             }
 
             declare_var(id->value, id->line); // Add variable to the table
@@ -301,7 +486,7 @@ void interpret_statement()
             if (!match(TOKEN_ENDOFLINE, NULL))
             {
                 fprintf(stderr, "[ERROR]: Expected ';' after declaration\n");
-                exit(1);
+                error_exit();
             }
         }
 
@@ -311,6 +496,12 @@ void interpret_statement()
             interpret_write(); // Handle 'write' keyword and output values
         }
 
+        // Read statement: read <identifier>;
+        else if (strcmp(t->value, "read") == 0)
+        {
+            interpret_read(); // Take the next number of the input
+        }
+
         // Repeat statement: repeat n times { }
         else if (strcmp(t->value, "repeat") == 0)
         {
@@ -321,7 +512,7 @@ void interpret_statement()
         else
         {
             fprintf(stderr, "[ERROR]: Unknown keyword '%s' at line %d\n", t->value, t->line);
-            exit(1);
+            error_exit();
         }
     }
 
@@ -329,61 +520,166 @@ void interpret_statement()
     else if (t->type == TOKEN_IDENTIFIER)
     {
         Token *id = advance();  // Get the variable being assigned
-        Token *op = advance();  // Get the operator (:=, +=, -=)
+        Token *op = advance();  // Get the operator (:=, +=, -=, *=, /=, %=, ^=)
         Token *rhs = advance(); // Get the right-hand side (value or identifier)
 
-        long long value = get_value(rhs);      // Convert RHS to a numeric value
+        const BigInt *value = get_value(rhs);  // Convert RHS to a numeric value
         int idx = find_var(id->value);         // Look up variable index
         check_var_exists(id->value, id->line); // Ensure the variable is declared
+        COUNT_BIGINT_OPERATION(var_table[idx].value.length, value->length);
 
         // Perform assignment operation based on operator
         if (strcmp(op->value, ":=") == 0)
         {
-            var_table[idx].value = value; // Direct assignment
+            // The first top-level constant assignment to a bound variable is the default its parameter replaces
+            if (!(frame_depth == 0 && rhs->type == TOKEN_INTCONST && parameter_count > 0 && skip_parameter_default(id->value)))
+                bigint_copy(variable_value(idx), value); // Direct assignment
         }
         else if (strcmp(op->value, "+=") == 0)
         {
-            var_table[idx].value += value; // Increment by value
+            accumulate(idx, value, 0); // Increment by value
         }
         else if (strcmp(op->value, "-=") == 0)
         {
-            var_table[idx].value -= value; // Decrement by value
+            accumulate(idx, value, 1); // Decrement by value
+        }
+        else if (strcmp(op->value, "*=") == 0)
+        {
+            bigint_mul(variable_value(idx), value); // Multiply by value
+        }
+        else if (strcmp(op->value, "/=") == 0)
+        {
+            check_arithmetic(bigint_div(variable_value(idx), value), op->line); // Divide by value, rounding toward zero
+        }
+        else if (strcmp(op->value, "%=") == 0)
+        {
+            check_arithmetic(bigint_mod(variable_value(idx), value), op->line); // Remainder of the division by value
+        }
+        else if (strcmp(op->value, "^=") == 0)
+        {
+            check_arithmetic(bigint_pow(variable_value(idx), value), op->line); // Raise to the power of value
         }
         else
         {
             // Invalid operator
             fprintf(stderr, "[ERROR]: Unknown operator '%s'\n", op->value);
-            exit(1);
+            error_exit();
         }
 
         // Every assignment must end with a semicolon
         if (!match(TOKEN_ENDOFLINE, NULL))
         {
             fprintf(stderr, "[ERROR]: Expected ';' after assignment.\n");
-            exit(1);
+            error_exit();
         }
     }
 
     // Block statement: { }
     else if (t->type == TOKEN_OPENBLOCK)
     {
-        interpret_block(); // Recursively interpret a code block
+        interpret_block(); // Enter a code block
     }
 
     // Invalid or unexpected token
     else
     {
         fprintf(stderr, "[ERROR]: Unexpected token '%s' on line %d\n", t->value, t->line);
-        exit(1);
+        error_exit();
     }
 }
 
-// Main function to interpret all statements from the token list
-void interpret()
+// Function to execute statements until the top level reaches the given token index or the program ends,
+// using the frame stack for blocks and loops
+void run_until(int end)
 {
-    current = 0;
-    while (peek())
+    long long steps = 0; // Statements executed since the last check of the checkpoint and metrics timers
+
+    while (1)
     {
+        // Close finished blocks and start the next iteration of finished loop bodies
+        if (frame_depth > 0 && current == frame_stack[frame_depth - 1].body_end)
+        {
+            if (profiling)
+            {
+                // Loop control belongs to the loop (or block) that is ending
+                const Frame *f = &frame_stack[frame_depth - 1];
+                profile_start(f->count_token >= 0 ? f->count_token - 1 : f->body_start - 1, frame_depth - 1, 0);
+                end_frame();
+                profile_stop();
+                continue;
+            }
+            end_frame();
+            continue;
+        }
+
+        if (!peek() || (frame_depth == 0 && current >= end))
+            break; // End of the program (or of the requested part)
+
+        // Checking the clock is comparatively slow, so only do it every few thousand statements
+        if ((options.checkpoint_file || options.metrics_file) && ++steps >= CHECKPOINT_POLL_INTERVAL)
+        {
+            steps = 0;
+            if (options.checkpoint_file)
+                poll_checkpoint();
+            if (options.metrics_file)
+                poll_metrics();
+        }
+
+        // A status report was requested with SIGUSR1
+        if (status_requested)
+            report_status(NULL, 0, 0, 0);
+
+        // Hot loop bodies run as compiled code, one iteration at a time
+        if (frame_depth > 0 && frame_stack[frame_depth - 1].count_token >= 0 &&
+            current == frame_stack[frame_depth - 1].body_start && compiled_bodies[current])
+        {
+            // An iteration counts with all the statements it ran, so hot loops reach the timers as often as
+            // interpreted ones
+            long long executed = statements_executed;
+            run_compiled(compiled_bodies[current]);
+            steps += statements_executed - executed;
+            current = frame_stack[frame_depth - 1].body_end;
+            continue;
+        }
+
+        // Each top-level statement is a span of the trace
+        if ((trace_spans & TRACE_EXEC) && frame_depth == 0)
+            trace_statement(current);
+
+        statements_executed++;
+        if (profiling)
+        {
+            profile_start(current, frame_depth, 1);
+            interpret_statement();
+            profile_stop();
+            continue;
+        }
         interpret_statement();
     }
+
+    if (trace_spans & TRACE_EXEC)
+        trace_statement(-1);
+}
+
+// Function to execute statements until the end of the program
+void run_program()
+{
+    find_block_ends();
+    forget_compiled_bodies();
+    run_until(token_count);
+}
+
+// Main function to interpret all statements from the token list
+void interpret()
+{
+    current = 0;
+    frame_depth = 0;
+    var_count = 0;
+
+    // Independent top-level loops may run side by side; checkpoints need a single execution state, and the profile,
+    // trace and metrics are collected in this process
+    if (options.parallel && !options.checkpoint_file && !profiling && !trace_spans && !options.metrics_file)
+        run_regions();
+    else
+        run_program();
 }
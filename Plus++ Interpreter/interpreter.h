@@ -1,7 +1,76 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "lexer.h"
+#include "bigint.h"
+
+#define MAX_VARS 100
+
+// A simple structure to represent a variable in the program
+typedef struct
+{
+    char name[64];
+    BigInt value;
+    CarrySave carries; // Carries of += and -= still pending in value; read the value through variable_value()
+    int initialized;
+} Variable;
+
+// An entry of the execution stack: an open { } block or an active repeat loop
+typedef struct
+{
+    int count_token;     // Index of the repeat count token, -1 for a plain block
+    int body_start;      // Index of the first token of the repeated statement
+    int body_end;        // Index where the frame ends: the '}' of a block, or just past the repeated statement
+    long long remaining; // Iterations left in a repeat loop, including the one currently running
+} Frame;
+
+// Execution state: variables, the stack of open blocks/loops (which grows as needed) and the current token position
+extern Variable var_table[MAX_VARS];
+extern int var_count;
+extern Frame *frame_stack;
+extern int frame_depth;
+extern int current;
+
+// Makes room for at least count frames
+void reserve_frames(int count);
+
+// Finds the index of a variable in var_table, -1 if it is not declared
+int find_var(const char *name);
+
+// Returns the value of a variable with any pending carries propagated, ready to be read or overwritten
+BigInt *variable_value(int idx);
+
+// Adds value to a variable (subtracts it if negate is set). Wide sums keep their carries pending until the value is read.
+void accumulate(int idx, const BigInt *value, int negate);
+
+// Stops with a runtime error if an arithmetic operation failed (e.g. division by zero)
+void check_arithmetic(int status, int line);
+
+// Stops with a runtime error if reading a number from the input failed (e.g. at the end of the input)
+void check_input(int status, int line);
+
+// Returns 1 if the program has a read statement, whose output then depends on the input
+int program_reads_input();
+
+// Returns 1 if the program (with its modules) declares a variable of the given name anywhere
+int program_declares(const char *name);
+
+// Matches every '{' with its '}' and sizes the tables kept per token; must run before statement_end is used
+void find_block_ends();
+
+// Returns the index just past the statement starting at the given token
+int statement_end(int start);
+
+// Drops the compiled loop bodies, which belong to the previous token list
+void forget_compiled_bodies();
+
+// Executes statements until the top level reaches the token index end or the program ends
+void run_until(int end);
+
 // Interpreter function to be called after parser
 void interpret();
 
+// Continues executing from the current execution state (e.g. after it was restored from a checkpoint)
+void run_program();
+
 #endif
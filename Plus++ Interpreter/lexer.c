@@ -3,14 +3,30 @@
 #include <string.h>
 #include <ctype.h>
 #include "lexer.h"
+#include "error.h"
+#include "trace.h"
+#include "memory.h"
+#include "module.h"
+#include "file_utils.h"
 
-Token token_list[MAX_TOKENS];
+Token *token_list = NULL;
 int token_count = 0;
+int token_capacity = 0;
 int peekc;
 
+// Number of characters consumed so far and the offset where the current token starts
+int lexer_offset = 0;
+int token_start = 0;
+
+// Optional check called after every ';', '{' and '}' token. Tokenizing stops early when it returns 1.
+int (*tokenize_stop_hook)(const Token *t) = NULL;
+
+// Optional handler for identifiers that are not declared. The identifier is an error unless it returns 1.
+int (*undeclared_identifier_hook)(const Token *t) = NULL;
+
 // List of keywords used in the language.
 const char *keywords[] = {
-    "number", "repeat", "times", "write", "newline", "and", NULL};
+    "number", "repeat", "times", "write", "newline", "and", "include", "read", NULL};
 
 // Function to check if an IntConstant is longer than 100 digits
 void check_intconstant_length(const char *num, int line)
@@ -24,7 +40,7 @@ void check_intconstant_length(const char *num, int line)
     if (len > 100)
     {
         fprintf(stderr, "[ERROR]: (Line %d): IntConstant exceeds 100 digits.\n", line);
-        exit(1);
+        error_exit();
     }
 }
 
@@ -34,7 +50,7 @@ void check_identifier_length(const char *name, int line)
     if (strlen(name) > 20)
     {
         fprintf(stderr, "[ERROR]: (Line %d): Identifier exceeds 20 characters.\n", line);
-        exit(1);
+        error_exit();
     }
 }
 
@@ -61,10 +77,12 @@ int is_identifier_char(char c)
     return isalnum(c) || c == '_';
 }
 
-// Maximum number of identifiers that can be stored.
-#define MAX_IDENTIFIERS 256
-// Array to store the names of declared identifiers (for example variable names).
+// Array to store the names of declared identifiers (for example variable names). The names live in
+// identifier_arena, in the order they were declared.
 char *declared_identifiers[MAX_IDENTIFIERS];
+Arena identifier_arena;
+// Number of tokens in the list when each identifier was declared
+int declared_tokens[MAX_IDENTIFIERS];
 // Keeps track of how many identifiers have been declared so far.
 int declared_count = 0;
 
@@ -84,20 +102,59 @@ void declare_identifier(const char *name)
 {
     if (declared_count < MAX_IDENTIFIERS)
     {
-        declared_identifiers[declared_count++] = strdup(name); // Store a copy of the name
+        declared_tokens[declared_count] = token_count;
+        declared_identifiers[declared_count++] = arena_strdup(&identifier_arena, name); // Store a copy of the name
     }
 }
 
-// Function to write a token to the output file in the format: TYPE(VALUE) If value is NULL, writes only the type.
-void write_token(FILE *out, const char *type_str, const char *value_str, int line)
+// Function to forget the most recently declared identifiers. Their names are the end of the arena.
+void forget_identifiers(int count)
+{
+    if (count >= declared_count)
+        return;
+    if (count == 0)
+        arena_reset(&identifier_arena);
+    else
+        arena_rewind(&identifier_arena, declared_identifiers[count]);
+    declared_count = count;
+}
+
+// Function to make room for at least count tokens, doubling the list so appending stays cheap
+void reserve_tokens(int count)
+{
+    if (count <= token_capacity)
+        return;
+    int capacity = token_capacity ? token_capacity : 1024;
+    while (capacity < count)
+        capacity *= 2;
+    token_list = memory_realloc(token_list, token_capacity * sizeof(Token), capacity * sizeof(Token));
+    token_capacity = capacity;
+}
+
+// Function to read the next character, keeping track of the offset in the source
+int read_char(FILE *in)
 {
+    int c = fgetc(in);
+    if (c != EOF)
+        lexer_offset++;
+    return c;
+}
 
-    if (token_count >= MAX_TOKENS)
+// Function to push back a character read one too far
+void unread_char(int c, FILE *in)
+{
+    if (c != EOF)
     {
-        fprintf(stderr, "[ERROR]: Too many tokens.\n");
-        exit(1);
+        ungetc(c, in);
+        lexer_offset--;
     }
+}
 
+// Function to write a token to the output file in the format: TYPE(VALUE) If value is NULL, writes only the type.
+void write_token(FILE *out, const char *type_str, const char *value_str, int line)
+{
+
+    reserve_tokens(token_count + 1);
     Token *t = &token_list[token_count++];
 
     // Set token type
@@ -127,45 +184,189 @@ void write_token(FILE *out, const char *type_str, const char *value_str, int lin
         t->value[0] = '\0';
 
     t->line = line;
+    t->offset = token_start;
+    t->length = lexer_offset - token_start;
+
+    // Trace every token at the verbose level
+    if (TRACING(TRACE_LEX, TRACE_VERBOSE))
+    {
+        if (value_str)
+            trace_message(TRACE_LEX, "line %d: %s(%s)", line, type_str, value_str);
+        else
+            trace_message(TRACE_LEX, "line %d: %s", line, type_str);
+    }
 
-    // Write token to file
+    // Write token to file (skipped when there is no output file, e.g. in the REPL)
+    if (!out)
+        return;
     if (value_str)
         fprintf(out, "%s(%s)\n", type_str, value_str);
     else
         fprintf(out, "%s\n", type_str);
 }
 
-// Main tokenizer function. Reads characters from the input file and writes tokens to the output file.
+// Function to check whether the last token is the target of a statement, as in "x" of "x *= 2;". Only there a '*'
+// followed by '=' is the multiply operator; everywhere else '*' starts a comment. Tokenizing always starts at a
+// statement boundary, so a first token at first_token starts a statement.
+int after_statement_target(int first_token)
+{
+    int last = token_count - 1;
+    if (last < first_token || token_list[last].type != TOKEN_IDENTIFIER)
+        return 0;
+    if (last == first_token)
+        return 1;
+
+    Token *before = &token_list[last - 1];
+    return before->type == TOKEN_ENDOFLINE || before->type == TOKEN_OPENBLOCK || before->type == TOKEN_CLOSEBLOCK ||
+           (before->type == TOKEN_KEYWORD && strcmp(before->value, "times") == 0);
+}
+
+// Function to skip whitespace and return the next character, counting the line breaks
+int skip_whitespace(FILE *in, int *line)
+{
+    int c;
+    while ((c = read_char(in)) != EOF && isspace(c))
+    {
+        if (c == '\n')
+            (*line)++;
+    }
+    return c;
+}
+
+// Function to check whether the token list already has the tokens of a module, included directly or by another module
+int is_included(const char *filename)
+{
+    for (int i = 0; i < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_OPENBLOCK && strcmp(token_list[i].value, filename) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Function to read the rest of an include statement, "name";, and add the module's tokens as a block. The block's
+// '{' holds the module's file name and its '}' the hash of the module's source; both, like the module's tokens, span
+// the include statement in the source. The module's declarations are declared here as well. A module is included once
+// per program (declaring its variables again would be an error), so including it again adds an empty block.
+void include_statement(FILE *in, FILE *out, int *line)
+{
+    char name[MAX_MODULE_NAME + 1];
+    int length = 0;
+    int c = skip_whitespace(in, line);
+    if (c != '\"')
+    {
+        fprintf(stderr, "[ERROR] (Line %d): Expected a module name in quotes after 'include'.\n", *line);
+        error_exit();
+    }
+    while ((c = read_char(in)) != EOF && c != '\"' && c != '\n')
+    {
+        if (length == MAX_MODULE_NAME)
+        {
+            fprintf(stderr, "[ERROR] (Line %d): Module name exceeds %d characters.\n", *line, MAX_MODULE_NAME);
+            error_exit();
+        }
+        name[length++] = c;
+    }
+    name[length] = '\0';
+    if (c != '\"')
+    {
+        fprintf(stderr, "[ERROR] (Line %d): Unterminated module name.\n", *line);
+        error_exit();
+    }
+    if (skip_whitespace(in, line) != ';')
+    {
+        fprintf(stderr, "[ERROR] (Line %d): Expected ';' after include.\n", *line);
+        error_exit();
+    }
+
+    char filename[128];
+    source_filename(name, filename, sizeof(filename));
+    const Module *module = load_module(filename, *line);
+
+    int count = is_included(filename) ? 0 : module->token_count;
+
+    write_token(out, "OpenBlock", filename, *line);
+    reserve_tokens(token_count + count + 1);
+    memcpy(&token_list[token_count], module->tokens, count * sizeof(Token));
+    for (int i = token_count; i < token_count + count; i++)
+    {
+        token_list[i].offset = token_start;
+        token_list[i].length = lexer_offset - token_start;
+    }
+    token_count += count;
+
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)module->hash);
+    write_token(out, "CloseBlock", hash, *line);
+
+    int first = token_count - 1 - count; // The module's first token
+    for (int i = 0; i + 1 < count; i++)
+    {
+        if (module->tokens[i].type == TOKEN_KEYWORD && strcmp(module->tokens[i].value, "number") == 0 &&
+            !is_declared(module->tokens[i + 1].value) && declared_count < MAX_IDENTIFIERS)
+        {
+            declare_identifier(module->tokens[i + 1].value);
+            declared_tokens[declared_count - 1] = first + i + 1; // Declared by its token in the block
+        }
+    }
+}
+
+// Main tokenizer function. Reads characters from the input file and writes tokens to the output file (if not NULL).
 void tokenize(FILE *in, FILE *out)
+{
+    tokenize_at(in, out, 1, 0);
+}
+
+// Tokenizes input that starts at the given line and offset of a larger source (used for incremental re-lexing)
+void tokenize_at(FILE *in, FILE *out, int start_line, int start_offset)
 {
     int c;
-    int line = 1;                          // Track current line number for error reporting.
+    int line = start_line;                 // Track current line number for error reporting.
     int expect_identifier_declaration = 0; // After "number", expect an identifier.
+    int first_token = token_count;         // First token produced by this call
+
+    lexer_offset = start_offset;
 
     // Main loop: read the input file one character at a time.
-    while ((c = fgetc(in)) != EOF)
+    while ((c = read_char(in)) != EOF)
     {
+        token_start = lexer_offset - 1;
 
         // Handle newlines to track line numbers.
         if (c == '\n')
         {
             line++;
-            fprintf(stderr, "Debug: Line %d\n", line); // Optional: print current line number
+            if (TRACING(TRACE_LEX, TRACE_DEBUG))
+                trace_message(TRACE_LEX, "line %d", line);
         }
 
         // If block to search and write End Of Line token
         if (c == ';')
         {
             write_token(out, "EndOfLine", NULL, line);
+            if (tokenize_stop_hook && tokenize_stop_hook(&token_list[token_count - 1]))
+                return;
             continue;
         }
 
+        // Multiply operator, written right after the target of a statement
+        if (c == '*' && after_statement_target(first_token))
+        {
+            int next = read_char(in);
+            if (next == '=')
+            {
+                write_token(out, "Operator", "*=", line);
+                continue;
+            }
+            unread_char(next, in); // Not an operator: a comment after all
+        }
+
         // If block to search and write Comment token
         if (c == '*')
         {
             int comment_closed = 0;
             int comment_start_line = line;
-            while ((c = fgetc(in)) != EOF)
+            while ((c = read_char(in)) != EOF)
             {
                 if (c == '\n')
                     line++; // Allow multiline comments
@@ -180,7 +381,7 @@ void tokenize(FILE *in, FILE *out)
                 // Report error if comment is not closed
                 fprintf(stderr, "[ERROR]: Unterminated comment detected at line %d\n", comment_start_line);
                 write_token(out, "Error", "Unterminated comment detected.", line);
-                exit(1);
+                error_exit();
             }
             continue;
         }
@@ -189,6 +390,8 @@ void tokenize(FILE *in, FILE *out)
         if (c == '{')
         {
             write_token(out, "OpenBlock", NULL, line);
+            if (tokenize_stop_hook && tokenize_stop_hook(&token_list[token_count - 1]))
+                return;
             continue;
         }
 
@@ -196,6 +399,8 @@ void tokenize(FILE *in, FILE *out)
         if (c == '}')
         {
             write_token(out, "CloseBlock", NULL, line);
+            if (tokenize_stop_hook && tokenize_stop_hook(&token_list[token_count - 1]))
+                return;
             continue;
         }
 
@@ -207,7 +412,7 @@ void tokenize(FILE *in, FILE *out)
             int str_closed = 0;
             int str_line = line;
 
-            while ((c = fgetc(in)) != EOF && i < 255)
+            while ((c = read_char(in)) != EOF && i < 255)
             {
                 if (c == '\"')
                 {
@@ -231,15 +436,28 @@ void tokenize(FILE *in, FILE *out)
                 // Unterminated string literal
                 fprintf(stderr, "[ERROR] (Line %d): Unterminated string constant.\n", str_line);
                 write_token(out, "Error", "Unterminated string constant.", line);
-                exit(1);
+                error_exit();
             }
             continue;
         }
 
+        // Divide, modulo and power operators
+        if (c == '/' || c == '%' || c == '^')
+        {
+            int next = read_char(in);
+            char op[3] = {c, '\0', '\0'};
+            if (next == '=')
+                op[1] = '=';
+            else
+                unread_char(next, in); // Single operator, rejected by the parser
+            write_token(out, "Operator", op, line);
+            continue;
+        }
+
         // Operator or negative int constant
         if (c == ':' || c == '+' || c == '-')
         {
-            int next = fgetc(in);
+            int next = read_char(in);
 
             // Dual operator control
             if (c == ':' && next == '=')
@@ -263,13 +481,14 @@ void tokenize(FILE *in, FILE *out)
                 num[i++] = c;
                 num[i++] = next;
 
-                while ((next = fgetc(in)) != EOF && isdigit(next))
+                while ((next = read_char(in)) != EOF && isdigit(next))
                 {
-                    num[i++] = next;
+                    if (i < (int)sizeof(num) - 1)
+                        num[i++] = next; // Longer constants are rejected by the length check below
                 }
 
                 num[i] = '\0';
-                ungetc(next, in);
+                unread_char(next, in);
 
                 check_intconstant_length(num, line);
                 write_token(out, "IntConstant", num, line);
@@ -277,7 +496,7 @@ void tokenize(FILE *in, FILE *out)
             else
             {
                 // Single operator
-                ungetc(next, in);
+                unread_char(next, in);
                 char op[2] = {c, '\0'};
                 write_token(out, "Operator", op, line);
             }
@@ -291,13 +510,14 @@ void tokenize(FILE *in, FILE *out)
             int i = 0;
 
             num[i++] = c;
-            while ((c = fgetc(in)) != EOF && isdigit(c))
+            while ((c = read_char(in)) != EOF && isdigit(c))
             {
-                num[i++] = c;
+                if (i < (int)sizeof(num) - 1)
+                    num[i++] = c; // Longer constants are rejected by the length check below
             }
 
             num[i] = '\0';
-            ungetc(c, in);
+            unread_char(c, in);
 
             check_intconstant_length(num, line);
             write_token(out, "IntConstant", num, line);
@@ -310,17 +530,24 @@ void tokenize(FILE *in, FILE *out)
             char word[64];
             int i = 0;
             word[i++] = c;
-            while ((c = fgetc(in)) != EOF && is_identifier_char(c))
+            while ((c = read_char(in)) != EOF && is_identifier_char(c))
             {
                 word[i++] = c;
             }
             word[i] = '\0';
-            ungetc(c, in); // Return the non-identifier character
+            unread_char(c, in); // Return the non-identifier character
 
             check_identifier_length(word, line);
 
+            // An include statement is replaced by the tokens of the module
+            if (strcmp(word, "include") == 0)
+            {
+                include_statement(in, out, &line);
+                if (tokenize_stop_hook && tokenize_stop_hook(&token_list[token_count - 1]))
+                    return;
+            }
             // Check if the word is a keyword
-            if (is_keyword(word))
+            else if (is_keyword(word))
             {
                 write_token(out, "Keyword", word, line);
                 // If it's the "number" keyword, expect an identifier next
@@ -344,12 +571,19 @@ void tokenize(FILE *in, FILE *out)
                 }
                 else
                 {
-                    // Undeclared identifier used — this is an error
+                    // Undeclared identifier used — this is an error, unless the handler keeps the token
+                    if (undeclared_identifier_hook)
+                    {
+                        write_token(out, "Identifier", word, line);
+                        if (undeclared_identifier_hook(&token_list[token_count - 1]))
+                            continue;
+                        token_count--;
+                    }
                     char err_msg[128];
                     sprintf(err_msg, "'%s' is not defined", word);
                     fprintf(stderr, "[ERROR] (Line %d): %s\n", line, err_msg);
                     write_token(out, "Error", err_msg, line);
-                    exit(1);
+                    error_exit();
                 }
             }
             continue;
@@ -362,7 +596,7 @@ void tokenize(FILE *in, FILE *out)
             sprintf(err_msg, "[ERROR]: Unrecognized character '%c'", c);
             fprintf(stderr, "[ERROR] (Line %d): %s\n", line, err_msg);
             write_token(out, "Error", err_msg, line);
-            exit(1);
+            error_exit();
         }
     }
 }
\ No newline at end of file
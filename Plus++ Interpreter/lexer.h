@@ -24,21 +24,54 @@ typedef struct
     TokenType type;
     char value[128];
     int line;
+    int offset; // Position of the first character of the token in the source
+    int length; // Number of source characters the token spans
 } Token;
 
-// Maximum number of tokens allowed in the program
-#define MAX_TOKENS 1024
+// Global list to store all tokens found during lexical analysis. It grows as needed (within --max-memory).
+extern Token *token_list;
 
-// Global list to store all tokens found during lexical analysis
-extern Token token_list[MAX_TOKENS];
-
-// Global counter to track the number of tokens stored
+// Global counter to track the number of tokens stored, and the number of tokens there is room for
 extern int token_count;
+extern int token_capacity;
+
+// Makes room for at least count tokens
+void reserve_tokens(int count);
+
+// Maximum number of identifiers that can be declared
+#define MAX_IDENTIFIERS 256
+
+// Names declared with "number" so far, used to reject undeclared identifiers
+extern char *declared_identifiers[MAX_IDENTIFIERS];
+extern int declared_count;
+
+// Number of tokens in the list when each name was declared: the index of the identifier after "number", also for the
+// names declared in the block of an included module. Used to tell which declarations come before a token.
+extern int declared_tokens[MAX_IDENTIFIERS];
+
+// Adds a name to the declared identifiers
+void declare_identifier(const char *name);
+
+// Forgets the identifiers declared after the first count, freeing their names
+void forget_identifiers(int count);
+
+// Returns 1 if the name has been declared, 0 otherwise
+int is_declared(const char *name);
+
+// Optional check called after every ';', '{' and '}' token; tokenizing stops early when it returns 1
+extern int (*tokenize_stop_hook)(const Token *t);
+
+// Optional handler for an identifier that is not declared, called with its token. When it returns 1 the token is kept
+// and tokenizing goes on; otherwise the identifier is reported as not defined.
+extern int (*undeclared_identifier_hook)(const Token *t);
 
 // Retrieves the next token from the input stream
 Token get_next_token();
 
-// Tokenizes the given input file and optionally writes token information to an output file
+// Tokenizes the given input file and optionally writes token information to an output file (NULL for none)
 void tokenize(FILE *in, FILE *out);
 
+// Tokenizes input starting at the given line and source offset, appending to the token list
+void tokenize_at(FILE *in, FILE *out, int start_line, int start_offset);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+
+// Allocations from an arena are rounded up to this many bytes, which keeps them aligned for any type
+#define ARENA_ALIGNMENT 16
+
+long long memory_used = 0;
+long long memory_peak = 0;
+long long memory_limit = 0;
+void (*memory_limit_hook)(void) = NULL;
+
+// Function to stop after an allocation failed or would exceed the cap
+void memory_error(const char *message, long long bytes)
+{
+    if (memory_limit > 0)
+        fprintf(stderr, "[ERROR]: %s (%lld more bytes with %.1f of %.1f MB in use).\n", message, bytes,
+                memory_used / 1048576.0, memory_limit / 1048576.0);
+    else
+        fprintf(stderr, "[ERROR]: %s (%lld more bytes with %.1f MB in use).\n", message, bytes, memory_used / 1048576.0);
+    if (memory_limit_hook)
+        memory_limit_hook();
+    exit(1);
+}
+
+// Function to account for allocated or freed bytes
+void memory_charge(long long bytes)
+{
+    if (bytes > 0 && memory_limit > 0 && memory_used + bytes > memory_limit)
+        memory_error("Memory limit exceeded", bytes);
+    memory_used += bytes;
+    if (memory_used > memory_peak)
+        memory_peak = memory_used;
+}
+
+// Function to allocate accounted memory
+void *memory_alloc(size_t size)
+{
+    memory_charge((long long)size);
+    void *p = malloc(size);
+    if (!p && size > 0)
+        memory_error("Out of memory", (long long)size);
+    return p;
+}
+
+// Function to resize accounted memory
+void *memory_realloc(void *p, size_t old_size, size_t new_size)
+{
+    memory_charge((long long)new_size - (long long)old_size);
+    void *q = realloc(p, new_size);
+    if (!q && new_size > 0)
+        memory_error("Out of memory", (long long)new_size);
+    return q;
+}
+
+// Function to free accounted memory
+void memory_free(void *p, size_t size)
+{
+    if (!p)
+        return;
+    free(p);
+    memory_charge(-(long long)size);
+}
+
+// Function to hand out memory from an arena, starting a new chunk when the current one is full
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    ArenaChunk *chunk = arena->chunk;
+    if (!chunk || chunk->used + size > chunk->size)
+    {
+        size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        chunk = memory_alloc(sizeof(ArenaChunk) + chunk_size);
+        chunk->previous = arena->chunk;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        arena->chunk = chunk;
+    }
+
+    void *p = chunk->data + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+// Function to copy a string into an arena
+char *arena_strdup(Arena *arena, const char *s)
+{
+    size_t length = strlen(s) + 1;
+    char *copy = arena_alloc(arena, length);
+    memcpy(copy, s, length);
+    return copy;
+}
+
+// Function to free the newest chunk of an arena
+void arena_drop_chunk(Arena *arena)
+{
+    ArenaChunk *chunk = arena->chunk;
+    arena->chunk = chunk->previous;
+    memory_free(chunk, sizeof(ArenaChunk) + chunk->size);
+}
+
+// Function to free the allocations from p on: the chunks newer than the one holding p, and the rest of that chunk
+void arena_rewind(Arena *arena, const void *p)
+{
+    const char *c = p;
+    while (arena->chunk && !(c >= arena->chunk->data && c < arena->chunk->data + arena->chunk->size))
+        arena_drop_chunk(arena);
+    if (arena->chunk)
+        arena->chunk->used = (size_t)(c - arena->chunk->data);
+}
+
+// Function to free all allocations of an arena, keeping its oldest chunk
+void arena_reset(Arena *arena)
+{
+    while (arena->chunk && arena->chunk->previous)
+        arena_drop_chunk(arena);
+    if (arena->chunk)
+        arena->chunk->used = 0;
+}
@@ -0,0 +1,57 @@
+// memory.h
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+// Bytes of the accounted allocations (tokens, per-token tables, identifiers, big number limbs and scratch space)
+// in use now and at most so far, and the cap on them (0 for none, set with --max-memory)
+extern long long memory_used;
+extern long long memory_peak;
+extern long long memory_limit;
+
+// Called when an allocation would go over the cap, after the error was printed; NULL to exit with status 1
+extern void (*memory_limit_hook)(void);
+
+// Adds bytes to the accounted memory (subtracts them if negative). Going over the cap is an error, so charge
+// memory before allocating it.
+void memory_charge(long long bytes);
+
+// Accounted malloc, realloc and free; the caller passes the sizes it allocated. Running out of memory is an error.
+void *memory_alloc(size_t size);
+void *memory_realloc(void *p, size_t old_size, size_t new_size);
+void memory_free(void *p, size_t size);
+
+// Size of the chunks an arena allocates, unless an allocation needs more
+#define ARENA_CHUNK_SIZE 16384
+
+// A chunk of an arena; chunks form a list from the newest to the oldest
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *previous;
+    size_t size; // Bytes of data
+    size_t used; // Bytes handed out
+    char data[];
+} ArenaChunk;
+
+// An arena hands out memory from large chunks and frees it all at once, instead of allocation by allocation.
+// A zero-initialized Arena is empty.
+typedef struct
+{
+    ArenaChunk *chunk;
+} Arena;
+
+// Returns size bytes from the arena, aligned for any type
+void *arena_alloc(Arena *arena, size_t size);
+
+// Returns a copy of a string in the arena
+char *arena_strdup(Arena *arena, const char *s);
+
+// Frees everything allocated from the arena since the allocation at p (including it)
+void arena_rewind(Arena *arena, const void *p);
+
+// Frees everything allocated from the arena. The first chunk is kept for the next run, so this is O(1) for the
+// usual arena that fits in a chunk.
+void arena_reset(Arena *arena);
+
+#endif
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "metrics.h"
+#include "bench.h"
+#include "lexer.h"
+#include "output.h"
+#include "perfcounters.h"
+#include "memory.h"
+#include "input.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+long long source_bytes = 0;
+long long statements_executed = 0;
+long long loop_iterations = 0;
+long long bigint_operations[METRICS_WIDTH_BUCKETS];
+
+// Labels of the width buckets
+const char *metrics_width_names[METRICS_WIDTH_BUCKETS] = {"1-2", "3-16", "17-256", "257-4096", "4097+"};
+
+// Names of the phases
+const char *metrics_phase_names[PHASE_COUNT] = {"tokenize", "parse", "interpret", "output"};
+
+// Seconds spent in each phase, and the start of the phases that are running (0 if not running)
+double phase_seconds[PHASE_COUNT];
+double phase_start[PHASE_COUNT];
+
+// Metrics file (NULL if the metrics are not written), seconds between writes and time of the next write
+const char *metrics_file = NULL;
+int metrics_interval = DEFAULT_METRICS_INTERVAL;
+time_t next_metrics = 0;
+
+// 1 once the program has run to its end
+int metrics_completed = 0;
+
+// Time the metrics were started
+double metrics_epoch = 0;
+
+// Function to get the peak resident memory of the process
+long long peak_rss_kb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return (long long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Function to mark the start of a phase
+void metrics_phase_begin(MetricsPhase phase)
+{
+    phase_start[phase] = bench_seconds();
+    if (perfcounters)
+        perfcounters_phase_begin(phase);
+}
+
+// Function to mark the end of a phase and add its time
+void metrics_phase_end(MetricsPhase phase)
+{
+    if (phase_start[phase] == 0)
+        return;
+    phase_seconds[phase] += bench_seconds() - phase_start[phase];
+    phase_start[phase] = 0;
+    if (perfcounters)
+        perfcounters_phase_end(phase);
+}
+
+// Function called around every write of the output buffer
+void time_output_flush(int starting)
+{
+    if (starting)
+        metrics_phase_begin(PHASE_OUTPUT);
+    else
+        metrics_phase_end(PHASE_OUTPUT);
+}
+
+// Function to time the writes of the output buffer
+void measure_output_phase()
+{
+    output_flush_hook = time_output_flush;
+}
+
+// Returns the time spent in a phase so far, including the part of it that is still running
+double phase_time(MetricsPhase phase)
+{
+    double seconds = phase_seconds[phase];
+    if (phase_start[phase] != 0)
+        seconds += bench_seconds() - phase_start[phase];
+    return seconds;
+}
+
+// Function to write the metrics as a JSON object
+void write_metrics_json(FILE *file)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"completed\": %d,\n", metrics_completed);
+    fprintf(file, "  \"elapsed_seconds\": %.6f,\n", bench_seconds() - metrics_epoch);
+    fprintf(file, "  \"source_bytes\": %lld,\n", source_bytes);
+    fprintf(file, "  \"tokens\": %d,\n", token_count);
+    fprintf(file, "  \"statements_executed\": %lld,\n", statements_executed);
+    fprintf(file, "  \"loop_iterations\": %lld,\n", loop_iterations);
+    fprintf(file, "  \"bigint_operations_by_limbs\": {");
+    for (int i = 0; i < METRICS_WIDTH_BUCKETS; i++)
+        fprintf(file, "%s\"%s\": %lld", i ? ", " : "", metrics_width_names[i], bigint_operations[i]);
+    fprintf(file, "},\n");
+    fprintf(file, "  \"output_bytes\": %lld,\n", output_bytes);
+    fprintf(file, "  \"output_flushes\": %lld,\n", output_flushes);
+    fprintf(file, "  \"input_bytes\": %lld,\n", input_bytes);
+    fprintf(file, "  \"input_numbers\": %lld,\n", input_numbers);
+    fprintf(file, "  \"peak_rss_bytes\": %lld,\n", peak_rss_kb() * 1024);
+    fprintf(file, "  \"accounted_memory_peak_bytes\": %lld,\n", memory_peak);
+    if (perfcounters)
+        write_perfcounters_json(file);
+    fprintf(file, "  \"phase_seconds\": {");
+    for (int i = 0; i < PHASE_COUNT; i++)
+        fprintf(file, "%s\"%s\": %.6f", i ? ", " : "", metrics_phase_names[i], phase_time(i));
+    fprintf(file, "}\n}\n");
+}
+
+// Function to write one Prometheus metric with its help and type lines
+void write_prometheus_metric(FILE *file, const char *name, const char *type, const char *help, long long value)
+{
+    fprintf(file, "# HELP ppp_%s %s\n# TYPE ppp_%s %s\nppp_%s %lld\n", name, help, name, type, name, value);
+}
+
+// Function to write the metrics in the Prometheus text format
+void write_metrics_prometheus(FILE *file)
+{
+    write_prometheus_metric(file, "completed", "gauge", "1 if the program ran to its end.", metrics_completed);
+    fprintf(file, "# HELP ppp_elapsed_seconds Time since the interpreter started.\n# TYPE ppp_elapsed_seconds gauge\n");
+    fprintf(file, "ppp_elapsed_seconds %.6f\n", bench_seconds() - metrics_epoch);
+    write_prometheus_metric(file, "source_bytes", "gauge", "Bytes of source lexed.", source_bytes);
+    write_prometheus_metric(file, "tokens", "gauge", "Tokens in the program.", token_count);
+    write_prometheus_metric(file, "statements_executed_total", "counter", "Statements executed.", statements_executed);
+    write_prometheus_metric(file, "loop_iterations_total", "counter", "Iterations of repeat loops.", loop_iterations);
+
+    fprintf(file, "# HELP ppp_bigint_operations_total Arithmetic operations by limbs of the longer operand.\n");
+    fprintf(file, "# TYPE ppp_bigint_operations_total counter\n");
+    for (int i = 0; i < METRICS_WIDTH_BUCKETS; i++)
+        fprintf(file, "ppp_bigint_operations_total{limbs=\"%s\"} %lld\n", metrics_width_names[i], bigint_operations[i]);
+
+    write_prometheus_metric(file, "output_bytes_total", "counter", "Bytes of program output.", output_bytes);
+    write_prometheus_metric(file, "output_flushes_total", "counter", "Writes of the output buffer.", output_flushes);
+    write_prometheus_metric(file, "input_bytes_total", "counter", "Bytes of input consumed by read statements.", input_bytes);
+    write_prometheus_metric(file, "input_numbers_total", "counter", "Numbers taken from the input.", input_numbers);
+    write_prometheus_metric(file, "peak_rss_bytes", "gauge", "Peak resident memory.", peak_rss_kb() * 1024);
+    write_prometheus_metric(file, "accounted_memory_peak_bytes", "gauge",
+                            "Peak memory of tokens, tables, identifiers and big numbers.", memory_peak);
+
+    fprintf(file, "# HELP ppp_phase_seconds Time spent in each phase.\n# TYPE ppp_phase_seconds gauge\n");
+    for (int i = 0; i < PHASE_COUNT; i++)
+        fprintf(file, "ppp_phase_seconds{phase=\"%s\"} %.6f\n", metrics_phase_names[i], phase_time(i));
+    if (perfcounters)
+        write_perfcounters_prometheus(file);
+}
+
+// Function to write the metrics file. It is written to a temporary file and renamed, so a collector reading it at
+// the same time never sees a half-written file.
+void write_metrics()
+{
+    if (!metrics_file)
+        return;
+
+    char temp_file[600];
+    snprintf(temp_file, sizeof(temp_file), "%s.tmp", metrics_file);
+    FILE *file = fopen(temp_file, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR]: Could not create metrics file '%s'.\n", temp_file);
+        return;
+    }
+
+    size_t length = strlen(metrics_file);
+    if (length > 5 && strcmp(metrics_file + length - 5, ".prom") == 0)
+        write_metrics_prometheus(file);
+    else
+        write_metrics_json(file);
+
+    int ok = !ferror(file);
+    if (fclose(file) != 0)
+        ok = 0;
+    remove(metrics_file); // rename() does not replace existing files on Windows
+    if (!ok || rename(temp_file, metrics_file) != 0)
+    {
+        fprintf(stderr, "[ERROR]: Could not write metrics file '%s'.\n", metrics_file);
+        remove(temp_file);
+    }
+}
+
+// Function to write the metrics a last time when the process exits
+void finish_metrics()
+{
+    output_flush(); // Count the last write of the output buffer
+    write_metrics();
+    metrics_file = NULL;
+}
+
+// Function to start writing the metrics
+void start_metrics(const char *file, int interval)
+{
+    metrics_file = file;
+    metrics_interval = interval;
+    metrics_epoch = bench_seconds();
+    next_metrics = time(NULL) + interval;
+    measure_output_phase();
+    atexit(finish_metrics);
+}
+
+// Function to write the metrics during a run
+void poll_metrics()
+{
+    time_t now = time(NULL);
+    if (now < next_metrics)
+        return;
+    next_metrics = now + metrics_interval;
+    write_metrics();
+}
+
+// Function to mark the run as completed
+void complete_metrics()
+{
+    metrics_completed = 1;
+}
@@ -0,0 +1,60 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+// Default number of seconds between two writes of the metrics file while a program runs
+#define DEFAULT_METRICS_INTERVAL 10
+
+// Big number operations are counted by the limbs of their longer operand, in buckets of up to 2 (64 bits),
+// 16, 256, 4096 and more limbs
+#define METRICS_WIDTH_BUCKETS 5
+// (the bucket is a sum of comparisons, which compiles without branches)
+#define METRICS_WIDTH_BUCKET(limbs) (((limbs) > 2) + ((limbs) > 16) + ((limbs) > 256) + ((limbs) > 4096))
+
+// Phases whose time is measured
+typedef enum
+{
+    PHASE_TOKENIZE,
+    PHASE_PARSE,
+    PHASE_INTERPRET,
+    PHASE_OUTPUT, // Writing the output buffer, which happens during the other phases
+    PHASE_COUNT
+} MetricsPhase;
+
+// Names of the phases
+extern const char *metrics_phase_names[PHASE_COUNT];
+
+// Counters of the run. They are always kept (each event is a single increment); --metrics only decides whether
+// they are written.
+extern long long source_bytes;        // Bytes of source that were lexed
+extern long long statements_executed; // Statements executed, in the interpreter and in compiled loop bodies
+extern long long loop_iterations;     // Iterations of repeat loops
+extern long long bigint_operations[METRICS_WIDTH_BUCKETS]; // Arithmetic operations by width
+
+// Counts an arithmetic operation on operands of the given lengths in limbs
+#define COUNT_BIGINT_OPERATION(a, b) (bigint_operations[METRICS_WIDTH_BUCKET((a) > (b) ? (a) : (b))]++)
+
+// Starts writing the metrics to file every interval seconds and when the process exits, also after an error.
+// Files ending in .prom get the Prometheus text format (for the node exporter's textfile collector), others JSON.
+void start_metrics(const char *file, int interval);
+
+// Marks the start and end of a phase
+void metrics_phase_begin(MetricsPhase phase);
+void metrics_phase_end(MetricsPhase phase);
+
+// Returns the seconds spent in a phase so far
+double phase_time(MetricsPhase phase);
+
+// Makes every write of the output buffer count as the output phase
+void measure_output_phase();
+
+// Writes the metrics file if the interval has passed
+void poll_metrics();
+
+// Marks the run as completed, which the metrics written at exit report
+void complete_metrics();
+
+// Returns the peak resident memory of the process so far in kB
+long long peak_rss_kb();
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "module.h"
+#include "lexer.h"
+#include "parser.h"
+#include "cache.h"
+#include "error.h"
+#include "memory.h"
+#include "trace.h"
+
+// External variables of the lexer and the parser, which belong to the including program while a module is loaded
+extern int lexer_offset;
+extern int token_start;
+extern int current;
+extern Token *last_token;
+extern int last_token_line;
+
+// Modules loaded by this process
+Module *modules = NULL;
+int module_count = 0;
+int module_capacity = 0;
+
+// State of the lexer and the parser of the including program, kept aside while a module is lexed and checked
+typedef struct
+{
+    Token *token_list;
+    int token_count;
+    int token_capacity;
+    char *declared_identifiers[MAX_IDENTIFIERS];
+    int declared_count;
+    int (*tokenize_stop_hook)(const Token *t);
+    int lexer_offset;
+    int token_start;
+    int current;
+    Token *last_token;
+    int last_token_line;
+    jmp_buf *error_recovery;
+} IncluderState;
+
+// Function to put the lexer and parser state of the including program aside and start with an empty one
+void save_includer_state(IncluderState *s)
+{
+    s->token_list = token_list;
+    s->token_count = token_count;
+    s->token_capacity = token_capacity;
+    memcpy(s->declared_identifiers, declared_identifiers, declared_count * sizeof(char *));
+    s->declared_count = declared_count;
+    s->tokenize_stop_hook = tokenize_stop_hook;
+    s->lexer_offset = lexer_offset;
+    s->token_start = token_start;
+    s->current = current;
+    s->last_token = last_token;
+    s->last_token_line = last_token_line;
+    s->error_recovery = error_recovery;
+
+    // A module only sees its own declarations. The names of the program stay in the identifier arena.
+    token_list = NULL;
+    token_count = 0;
+    token_capacity = 0;
+    declared_count = 0;
+    tokenize_stop_hook = NULL;
+    current = 0;
+    last_token = NULL;
+    last_token_line = -1;
+}
+
+// Function to go back to the lexer and parser state of the including program
+void restore_includer_state(const IncluderState *s)
+{
+    token_list = s->token_list;
+    token_count = s->token_count;
+    token_capacity = s->token_capacity;
+    memcpy(declared_identifiers, s->declared_identifiers, s->declared_count * sizeof(char *));
+    declared_count = s->declared_count;
+    tokenize_stop_hook = s->tokenize_stop_hook;
+    lexer_offset = s->lexer_offset;
+    token_start = s->token_start;
+    current = s->current;
+    last_token = s->last_token;
+    last_token_line = s->last_token_line;
+    error_recovery = s->error_recovery;
+}
+
+// Function to load a module: from memory if this process already has it, otherwise from its .pppc cache or by lexing
+// and checking its source. Errors in the module are followed by the line of the include statement.
+const Module *load_module(const char *filename, int line)
+{
+    FILE *file = fopen(filename, "r");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR] (Line %d): Could not open module '%s'.\n", line, filename);
+        error_exit();
+    }
+    uint64_t hash = hash_file(file);
+
+    // A module is identified by its file and content, so an edited module is loaded again
+    for (int i = 0; i < module_count; i++)
+    {
+        if (modules[i].hash == hash && strcmp(modules[i].filename, filename) == 0)
+        {
+            fclose(file);
+            if (modules[i].loading)
+            {
+                fprintf(stderr, "[ERROR] (Line %d): Include cycle: module '%s' includes itself.\n", line, filename);
+                error_exit();
+            }
+            return &modules[i];
+        }
+    }
+
+    if (module_count == module_capacity)
+    {
+        module_capacity = module_capacity ? module_capacity * 2 : 16;
+        modules = realloc(modules, module_capacity * sizeof(Module));
+    }
+    int m = module_count++; // An index, since modules included by this one can move the table
+    snprintf(modules[m].filename, sizeof(modules[m].filename), "%s", filename);
+    modules[m].hash = hash;
+    modules[m].tokens = NULL;
+    modules[m].token_count = 0;
+    modules[m].loading = 1;
+
+    IncluderState saved;
+    jmp_buf recovery;
+    save_includer_state(&saved);
+    if (setjmp(recovery) != 0)
+    {
+        // The module has an error: drop what was lexed of it and report the error at the include statement too
+        memory_free(token_list, token_capacity * sizeof(Token));
+        restore_includer_state(&saved);
+        fclose(file);
+        modules[m].filename[0] = '\0';
+        modules[m].loading = 0;
+        fprintf(stderr, "[ERROR] (Line %d): In module '%s' included here.\n", line, filename);
+        error_exit();
+    }
+    error_recovery = &recovery;
+
+    if (load_program_cache(filename, hash))
+    {
+        if (TRACING(TRACE_IO, TRACE_INFO))
+            trace_message(TRACE_IO, "module %s: %d tokens loaded from the program cache", filename, token_count);
+    }
+    else
+    {
+        tokenize(file, NULL);
+        parse_statements();
+        save_program_cache(filename, hash);
+        if (TRACING(TRACE_LEX, TRACE_INFO))
+            trace_message(TRACE_LEX, "module %s: %d tokens", filename, token_count);
+    }
+    fclose(file);
+
+    modules[m].tokens = token_list;
+    modules[m].token_count = token_count;
+    modules[m].loading = 0;
+    restore_includer_state(&saved);
+    return &modules[m];
+}
+
+// Function to find the '}' that closes an included module and return the index after it
+int included_module_end(int token)
+{
+    int depth = 0;
+    for (int i = token; i < token_count; i++)
+    {
+        if (token_list[i].type == TOKEN_OPENBLOCK)
+            depth++;
+        else if (token_list[i].type == TOKEN_CLOSEBLOCK && --depth == 0)
+            return i + 1;
+    }
+    return token_count;
+}
+
+// Function to check the included modules against their sources. The '{' of a module holds its file name and the
+// '}' the hash of the source it was lexed from.
+int included_modules_unchanged()
+{
+    for (int i = 0; i < token_count; i++)
+    {
+        if (token_list[i].type != TOKEN_OPENBLOCK || token_list[i].value[0] == '\0')
+            continue;
+
+        FILE *file = fopen(token_list[i].value, "r");
+        if (!file)
+            return 0;
+        uint64_t hash = hash_file(file);
+        fclose(file);
+        if (hash != strtoull(token_list[included_module_end(i) - 1].value, NULL, 16))
+            return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,32 @@
+// module.h
+#ifndef MODULE_H
+#define MODULE_H
+
+#include <stdint.h>
+#include "lexer.h"
+
+// Longest name accepted by include "name"; the file name (name.ppp) has to fit in a token value
+#define MAX_MODULE_NAME 100
+
+// A module lexed and checked by this process. Its tokens are copied into every program that includes it.
+typedef struct
+{
+    char filename[128]; // Source file of the module (name.ppp)
+    uint64_t hash;      // Hash of the source the tokens were produced from
+    Token *tokens;
+    int token_count;
+    int loading; // 1 while the module itself is lexed, so including it again from there is a cycle
+} Module;
+
+// Returns the module in the given source file, lexing and checking it only if this process has not done so for the
+// same source yet and its .pppc cache does not match. line is the line of the include statement, for errors.
+// The returned module is valid until the next call.
+const Module *load_module(const char *filename, int line);
+
+// Returns the index just past the included module whose '{' is at the given token
+int included_module_end(int token);
+
+// Returns 1 if the sources of all modules included in the token list are unchanged, 0 if one has changed
+int included_modules_unchanged();
+
+#endif
@@ -0,0 +1,433 @@
+#include <stdlib.h>
+#include <string.h>
+#include "ntt.h"
+#include "memory.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Number of threads the transform may use; 0 means one per processor
+int ntt_threads = 0;
+
+// Transforms shorter than this are not worth splitting across threads
+#define NTT_PARALLEL_MIN 16384
+
+// One of the primes the convolution is computed modulo, with its Montgomery constants (R = 2^32)
+typedef struct
+{
+    uint32_t p;    // Prime of the form c * 2^k + 1 with k >= 23, so transforms up to 2^23 points exist
+    uint32_t g;    // Primitive root modulo p
+    uint32_t pinv; // -p^-1 mod 2^32
+    uint32_t r2;   // R^2 mod p
+} NttPrime;
+
+// The three primes multiply to more than 2^86, which bounds every coefficient of a product of up to 2^23 limbs
+NttPrime ntt_primes[3] = {
+    {998244353u, 3, 0, 0},  // 119 * 2^23 + 1
+    {167772161u, 3, 0, 0},  // 5 * 2^25 + 1
+    {469762049u, 3, 0, 0}}; // 7 * 2^26 + 1
+
+// Function to compute (x * y / R) mod p for x * y < 2^62. The result is below p.
+uint32_t mont_mul(uint32_t x, uint32_t y, const NttPrime *m)
+{
+    uint64_t t = (uint64_t)x * y;
+    uint32_t q = (uint32_t)t * m->pinv;
+    uint32_t u = (uint32_t)((t + (uint64_t)q * m->p) >> 32);
+    return u >= m->p ? u - m->p : u;
+}
+
+// Function to compute base^exponent mod p (only used for setup, so plain modular arithmetic is fine)
+uint32_t pow_mod(uint32_t base, uint32_t exponent, uint32_t p)
+{
+    uint64_t result = 1, b = base % p;
+    while (exponent)
+    {
+        if (exponent & 1)
+            result = result * b % p;
+        b = b * b % p;
+        exponent >>= 1;
+    }
+    return (uint32_t)result;
+}
+
+// Function to fill in the Montgomery constants of the primes once
+void init_primes()
+{
+    if (ntt_primes[0].pinv)
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        NttPrime *m = &ntt_primes[i];
+        uint32_t inv = m->p; // Newton's iteration doubles the correct low bits of p^-1 mod 2^32 every step
+        for (int k = 0; k < 5; k++)
+            inv *= 2 - m->p * inv;
+        m->pinv = 0 - inv;
+        uint64_t r = ((uint64_t)1 << 32) % m->p;
+        m->r2 = (uint32_t)(r * r % m->p);
+    }
+}
+
+// Function to build the twiddle factor table for n points: roots[h + j] = w^j, with w a primitive (2h)-th root of
+// unity (its inverse when inverse is set), for every power of two h < n. Entries are in Montgomery form.
+void build_roots(uint32_t *roots, int n, int inverse, const NttPrime *m)
+{
+    uint32_t one = mont_mul(1, m->r2, m); // R mod p
+    for (int h = 1; h < n; h *= 2)
+    {
+        uint32_t w = pow_mod(m->g, (m->p - 1) / (2 * h), m->p);
+        if (inverse)
+            w = pow_mod(w, m->p - 2, m->p);
+        uint32_t w_mont = mont_mul(w, m->r2, m);
+
+        roots[h] = one;
+        for (int j = 1; j < h; j++)
+            roots[h + j] = mont_mul(roots[h + j - 1], w_mont, m);
+    }
+}
+
+// Function to run the decimation-in-frequency butterflies j in [from, to) of a block with half size h.
+// Natural order input gives bit-reversed output, so no reordering pass is needed between the transforms.
+void dif_butterflies(uint32_t *x, int h, int from, int to, const uint32_t *roots, const NttPrime *m)
+{
+    uint32_t p = m->p;
+    for (int j = from; j < to; j++)
+    {
+        uint32_t u = x[j], v = x[j + h];
+        uint32_t sum = u + v;
+        x[j] = sum >= p ? sum - p : sum;
+        x[j + h] = mont_mul(u + p - v, roots[h + j], m);
+    }
+}
+
+// Function to run the decimation-in-time butterflies j in [from, to) of a block with half size h (inverse transform)
+void dit_butterflies(uint32_t *x, int h, int from, int to, const uint32_t *roots, const NttPrime *m)
+{
+    uint32_t p = m->p;
+    for (int j = from; j < to; j++)
+    {
+        uint32_t u = x[j], v = mont_mul(x[j + h], roots[h + j], m);
+        uint32_t sum = u + v;
+        x[j] = sum >= p ? sum - p : sum;
+        x[j + h] = u >= v ? u - v : u + p - v;
+    }
+}
+
+// Function to transform a block of len points completely, one stage after another
+void transform_block(uint32_t *x, int len, int inverse, const uint32_t *roots, const NttPrime *m)
+{
+    if (!inverse)
+    {
+        for (int h = len / 2; h >= 1; h /= 2)
+            for (int s = 0; s < len; s += 2 * h)
+                dif_butterflies(x + s, h, 0, h, roots, m);
+    }
+    else
+    {
+        for (int h = 1; h < len; h *= 2)
+            for (int s = 0; s < len; s += 2 * h)
+                dit_butterflies(x + s, h, 0, h, roots, m);
+    }
+}
+
+// Work of one thread: a slice of the butterflies of a stage (h > 0), or a whole block transform (h == 0)
+typedef struct
+{
+    uint32_t *x;
+    int length; // Block length for block transforms
+    int h;      // Half size of the stage, 0 for a block transform
+    int from, to;
+    int inverse;
+    const uint32_t *roots;
+    const NttPrime *m;
+} NttTask;
+
+// Function to run one NttTask
+void run_ntt_task(void *argument)
+{
+    NttTask *task = argument;
+    if (task->h == 0)
+        transform_block(task->x, task->length, task->inverse, task->roots, task->m);
+    else if (!task->inverse)
+        dif_butterflies(task->x, task->h, task->from, task->to, task->roots, task->m);
+    else
+        dit_butterflies(task->x, task->h, task->from, task->to, task->roots, task->m);
+}
+
+// Thread entry point: calls the function of a ParallelCall on one of its arguments
+typedef struct
+{
+    void (*function)(void *);
+    void *argument;
+} ParallelCall;
+
+#ifdef _WIN32
+DWORD WINAPI parallel_thread(LPVOID call)
+{
+    ((ParallelCall *)call)->function(((ParallelCall *)call)->argument);
+    return 0;
+}
+#else
+void *parallel_thread(void *call)
+{
+    ((ParallelCall *)call)->function(((ParallelCall *)call)->argument);
+    return NULL;
+}
+#endif
+
+// Function to call function on count arguments (each argument_size bytes apart) in parallel and wait for all of them.
+// The first call runs on the calling thread; if a thread cannot be started, its call runs there too.
+void run_parallel(void (*function)(void *), void *arguments, size_t argument_size, int count)
+{
+    ParallelCall *calls = malloc(count * sizeof(ParallelCall));
+#ifdef _WIN32
+    HANDLE *threads = malloc(count * sizeof(HANDLE));
+#else
+    pthread_t *threads = malloc(count * sizeof(pthread_t));
+#endif
+    int *started = calloc(count, sizeof(int));
+
+    for (int i = 1; i < count; i++)
+    {
+        calls[i].function = function;
+        calls[i].argument = (char *)arguments + i * argument_size;
+#ifdef _WIN32
+        threads[i] = CreateThread(NULL, 0, parallel_thread, &calls[i], 0, NULL);
+        started[i] = threads[i] != NULL;
+#else
+        started[i] = pthread_create(&threads[i], NULL, parallel_thread, &calls[i]) == 0;
+#endif
+    }
+
+    function(arguments);
+    for (int i = 1; i < count; i++)
+    {
+        if (!started[i])
+        {
+            function(calls[i].argument);
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    free(calls);
+    free(threads);
+    free(started);
+}
+
+// Function to get the number of processors available
+int processor_count()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+
+// Function to get the number of threads to use, rounded down to a power of two
+int ntt_thread_count()
+{
+    int count = ntt_threads > 0 ? ntt_threads : processor_count();
+
+    int power = 1;
+    while (power * 2 <= count)
+        power *= 2;
+    return power;
+}
+
+// Function to transform n points. With T threads, the forward transform runs its first log2(T) stages with the
+// butterflies of each stage split across the threads, after which the array falls apart into T independent blocks
+// that are finished one per thread. The inverse transform does the same in reverse order.
+void transform(uint32_t *x, int n, int inverse, const uint32_t *roots, const NttPrime *m, int threads)
+{
+    if (threads < 2 || n < NTT_PARALLEL_MIN)
+    {
+        transform_block(x, n, inverse, roots, m);
+        return;
+    }
+
+    NttTask *tasks = malloc(threads * sizeof(NttTask));
+    int block = n / threads;
+    int slice = n / 2 / threads; // Butterflies per thread in a shared stage
+
+    // Every thread takes a slice of a single block, since slice <= h in the shared stages
+    int first_h = inverse ? block : n / 2;
+    for (int step = 0, h = first_h; step < 2; step++)
+    {
+        if (step == (inverse ? 1 : 0))
+        {
+            // Shared stages
+            for (int k = 0; (1 << k) < threads; k++)
+            {
+                for (int t = 0; t < threads; t++)
+                {
+                    int b = t * slice;
+                    int s = b / h * 2 * h;
+                    tasks[t] = (NttTask){x + s, 0, h, b % h, b % h + slice, inverse, roots, m};
+                }
+                run_parallel(run_ntt_task, tasks, sizeof(NttTask), threads);
+                h = inverse ? h * 2 : h / 2;
+            }
+        }
+        else
+        {
+            // Independent blocks
+            for (int t = 0; t < threads; t++)
+                tasks[t] = (NttTask){x + t * block, block, 0, 0, 0, inverse, roots, m};
+            run_parallel(run_ntt_task, tasks, sizeof(NttTask), threads);
+        }
+    }
+    free(tasks);
+}
+
+// Work of one thread in the multiplication: the convolution modulo one prime, or a range of the CRT reconstruction
+typedef struct
+{
+    const uint32_t *a, *b;
+    int an, bn, n;
+    uint32_t *x, *y; // Transform buffers; x holds the convolution modulo the prime afterwards
+    const NttPrime *m;
+    int threads;     // Threads the transforms of this prime may use
+    uint32_t *residues[3];
+    int from, to;
+} MultiplyTask;
+
+// Function to compute the cyclic convolution of a and b modulo one prime
+void convolve_mod_prime(void *argument)
+{
+    MultiplyTask *task = argument;
+    const NttPrime *m = task->m;
+    int n = task->n;
+    uint32_t *roots = malloc(n * sizeof(uint32_t));
+
+    for (int i = 0; i < n; i++)
+        task->x[i] = i < task->an ? task->a[i] % m->p : 0;
+    build_roots(roots, n, 0, m);
+    transform(task->x, n, 0, roots, m, task->threads);
+
+    // Squaring needs only one forward transform
+    if (task->a != task->b || task->an != task->bn)
+    {
+        for (int i = 0; i < n; i++)
+            task->y[i] = i < task->bn ? task->b[i] % m->p : 0;
+        transform(task->y, n, 0, roots, m, task->threads);
+    }
+    else
+    {
+        task->y = task->x;
+    }
+
+    // Pointwise products, scaled back out of Montgomery form and by 1/n for the inverse transform
+    uint32_t scale = mont_mul(pow_mod(n, m->p - 2, m->p), m->r2, m);
+    scale = mont_mul(scale, m->r2, m);
+    for (int i = 0; i < n; i++)
+        task->x[i] = mont_mul(mont_mul(task->x[i], task->y[i], m), scale, m);
+
+    build_roots(roots, n, 1, m);
+    transform(task->x, n, 1, roots, m, task->threads);
+    free(roots);
+}
+
+// Function to turn the residues of coefficients [from, to) into their exact values, as three 32-bit words stored
+// back over the residues (Garner's algorithm: x = r1 + m1 * (t2 + m2 * t3))
+void reconstruct_coefficients(void *argument)
+{
+    MultiplyTask *task = argument;
+    const NttPrime *m1 = &ntt_primes[0], *m2 = &ntt_primes[1], *m3 = &ntt_primes[2];
+    uint32_t *r1 = task->residues[0], *r2 = task->residues[1], *r3 = task->residues[2];
+
+    uint32_t inv_m1 = pow_mod(m1->p % m2->p, m2->p - 2, m2->p);
+    uint64_t m12 = (uint64_t)m1->p * m2->p;
+    uint32_t inv_m12 = pow_mod((uint32_t)(m12 % m3->p), m3->p - 2, m3->p);
+
+    for (int i = task->from; i < task->to; i++)
+    {
+        uint64_t t2 = (uint64_t)(r2[i] + m2->p - r1[i] % m2->p) * inv_m1 % m2->p;
+        uint64_t y2 = r1[i] + m1->p * t2; // Below m1 * m2 < 2^60
+        uint64_t t3 = (r3[i] + m3->p - y2 % m3->p) * (uint64_t)inv_m12 % m3->p;
+
+        // x = y2 + m12 * t3, below 2^86
+        uint64_t low = (m12 & 0xFFFFFFFFu) * t3 + (y2 & 0xFFFFFFFFu);
+        uint64_t high = (m12 >> 32) * t3 + (y2 >> 32) + (low >> 32);
+        r1[i] = (uint32_t)low;
+        r2[i] = (uint32_t)high;
+        r3[i] = (uint32_t)(high >> 32);
+    }
+}
+
+// Function to multiply with the number-theoretic transform
+void mag_mul_ntt(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn)
+{
+    init_primes();
+
+    int length = an + bn - 1; // Coefficients of the product
+    int n = 1;
+    while (n < length)
+        n *= 2;
+
+    // The three primes run in parallel, and the threads left over split their transforms
+    int threads = ntt_thread_count();
+    int per_prime = threads >= 6 ? threads / 4 : 1;
+    int prime_threads = threads >= 3 ? 3 : 1;
+
+    // Each transform also allocates its roots in its own thread; they are accounted for here
+    size_t buffers_size = (size_t)6 * n * sizeof(uint32_t), roots_size = (size_t)3 * n * sizeof(uint32_t);
+    uint32_t *buffers = memory_alloc(buffers_size);
+    memory_charge((long long)roots_size);
+    MultiplyTask tasks[3];
+    for (int i = 0; i < 3; i++)
+    {
+        tasks[i] = (MultiplyTask){a, b, an, bn, n, buffers + (size_t)2 * i * n, buffers + (size_t)(2 * i + 1) * n,
+                                  &ntt_primes[i], per_prime, {NULL, NULL, NULL}, 0, 0};
+    }
+    if (prime_threads == 3)
+    {
+        run_parallel(convolve_mod_prime, tasks, sizeof(MultiplyTask), 3);
+    }
+    else
+    {
+        for (int i = 0; i < 3; i++)
+            convolve_mod_prime(&tasks[i]);
+    }
+
+    // Reconstruct the coefficients in parallel ranges
+    int ranges = threads < length / 4096 ? threads : 1;
+    MultiplyTask *parts = malloc(ranges * sizeof(MultiplyTask));
+    for (int t = 0; t < ranges; t++)
+    {
+        parts[t] = tasks[0];
+        parts[t].residues[0] = tasks[0].x;
+        parts[t].residues[1] = tasks[1].x;
+        parts[t].residues[2] = tasks[2].x;
+        parts[t].from = (int)((long long)length * t / ranges);
+        parts[t].to = (int)((long long)length * (t + 1) / ranges);
+    }
+    run_parallel(reconstruct_coefficients, parts, sizeof(MultiplyTask), ranges);
+
+    // Add up the overlapping three-word coefficients with carries, which has to go in order
+    uint32_t *w0 = tasks[0].x, *w1 = tasks[1].x, *w2 = tasks[2].x;
+    uint64_t carry0 = 0, carry1 = 0; // Pending amounts for positions i and i + 1
+    for (int i = 0; i < an + bn; i++)
+    {
+        uint64_t sum = carry0 + (i < length ? w0[i] : 0);
+        r[i] = (uint32_t)sum;
+        carry0 = carry1 + (i < length ? w1[i] : 0) + (sum >> 32);
+        carry1 = i < length ? w2[i] : 0;
+    }
+
+    free(parts);
+    memory_charge(-(long long)roots_size);
+    memory_free(buffers, buffers_size);
+}
@@ -0,0 +1,23 @@
+// ntt.h
+#ifndef NTT_H
+#define NTT_H
+
+#include <stdint.h>
+
+// Size in limbs of the smaller operand from which multiplication switches from Karatsuba to the number-theoretic transform
+#define NTT_CUTOFF 1536
+
+// Longest product in limbs the transform computes exactly; longer products are first split by Karatsuba
+#define NTT_MAX_LIMBS (1 << 23)
+
+// Number of threads the transform may use; 0 means one per processor
+extern int ntt_threads;
+
+// Returns the number of processors available
+int processor_count();
+
+// Multiplies two magnitudes into r (an + bn limbs) with a number-theoretic transform modulo three primes,
+// combined with the Chinese remainder theorem. The result is exact for an + bn up to NTT_MAX_LIMBS.
+void mag_mul_ntt(uint32_t *r, const uint32_t *a, int an, const uint32_t *b, int bn);
+
+#endif
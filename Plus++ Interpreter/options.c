@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+#include "compiler.h"
+#include "params.h"
+#include "suite.h"
+#include "trace.h"
+#include "metrics.h"
+
+// Default options; the result cache is opt-in and limited to 64 MB
+Options options = {NULL, 64LL * 1024 * 1024, NULL, 0, NULL, DEFAULT_COMPILE_THRESHOLD, 0, 0, 0, 0, NULL, 0,
+                   NULL, NULL, DEFAULT_BENCH_THRESHOLD, NULL, 0, TRACE_OFF, TRACE_ALL, NULL, NULL, DEFAULT_METRICS_INTERVAL, 0, 0, NULL, 0};
+
+// Returns the value following an option, or stops with an error if it is missing
+const char *option_value(int argc, char *argv[], int i)
+{
+    if (i + 1 >= argc)
+    {
+        fprintf(stderr, "[ERROR]: Option '%s' requires a value.\n", argv[i]);
+        exit(1);
+    }
+    return argv[i + 1];
+}
+
+// Parses a positive number of megabytes given to an option
+long long option_megabytes(const char *name, const char *value)
+{
+    char *end;
+    long long mb = strtoll(value, &end, 10);
+    if (*end != '\0' || mb <= 0)
+    {
+        fprintf(stderr, "[ERROR]: Option '%s' expects a positive number of megabytes, got '%s'.\n", name, value);
+        exit(1);
+    }
+    return mb * 1024 * 1024;
+}
+
+// Parses the options and keeps only the positional arguments (e.g. the source name) in argv
+int parse_options(int argc, char *argv[])
+{
+    int remaining = 1; // argv[0] is always kept
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--result-cache") == 0)
+        {
+            options.result_cache_dir = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--result-cache-size") == 0)
+        {
+            options.result_cache_size = option_megabytes(argv[i], option_value(argc, argv, i));
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--checkpoint-every") == 0)
+        {
+            // --checkpoint-every SECONDS FILE
+            const char *seconds = option_value(argc, argv, i);
+            options.checkpoint_interval = atoi(seconds);
+            if (options.checkpoint_interval <= 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a positive number of seconds, got '%s'.\n", argv[i], seconds);
+                exit(1);
+            }
+            options.checkpoint_file = option_value(argc, argv, i + 1);
+            i += 2; // Skip both values
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            options.resume_file = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--compile-threshold") == 0)
+        {
+            const char *count = option_value(argc, argv, i);
+            options.compile_threshold = atoi(count);
+            if (options.compile_threshold < 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a number of iterations, got '%s'.\n", argv[i], count);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--check-edits") == 0)
+        {
+            const char *count = option_value(argc, argv, i);
+            options.check_edits = atoi(count);
+            if (options.check_edits <= 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a positive number of edits, got '%s'.\n", argv[i], count);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--emit-c") == 0)
+        {
+            options.emit_c = 1;
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            const char *count = option_value(argc, argv, i);
+            options.threads = atoi(count);
+            if (options.threads <= 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a positive number of threads, got '%s'.\n", argv[i], count);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--bench-multiply") == 0)
+        {
+            options.bench_multiply = 1;
+        }
+        else if (strcmp(argv[i], "--bench-kernels") == 0)
+        {
+            options.bench_kernels = 1;
+        }
+        else if (strcmp(argv[i], "--param") == 0)
+        {
+            // --param NAME=VALUE
+            const char *assignment = option_value(argc, argv, i);
+            const char *equals = strchr(assignment, '=');
+            char name[64];
+            size_t length = equals ? (size_t)(equals - assignment) : 0;
+            if (length > 0 && length < sizeof(name))
+            {
+                memcpy(name, assignment, length);
+                name[length] = '\0';
+            }
+            if (length == 0 || length >= sizeof(name) || !bind_parameter(name, equals + 1))
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects NAME=INTEGER, got '%s'.\n", argv[i], assignment);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--parallel") == 0)
+        {
+            options.parallel = 1;
+        }
+        else if (strcmp(argv[i], "--params") == 0)
+        {
+            options.params_file = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            options.profile = 1;
+        }
+        else if (strcmp(argv[i], "--trace") == 0)
+        {
+            const char *level = option_value(argc, argv, i);
+            options.trace_level = trace_level_value(level);
+            if (options.trace_level < 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects off, info, debug or verbose, got '%s'.\n", argv[i], level);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--trace-categories") == 0)
+        {
+            const char *list = option_value(argc, argv, i);
+            options.trace_categories = trace_category_mask(list);
+            if (!options.trace_categories)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a list of lex, parse, exec, io or all, got '%s'.\n", argv[i], list);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--trace-file") == 0)
+        {
+            options.trace_file = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--metrics") == 0)
+        {
+            options.metrics_file = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--metrics-interval") == 0)
+        {
+            const char *seconds = option_value(argc, argv, i);
+            options.metrics_interval = atoi(seconds);
+            if (options.metrics_interval <= 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a positive number of seconds, got '%s'.\n", argv[i], seconds);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--max-memory") == 0)
+        {
+            options.max_memory = option_megabytes(argv[i], option_value(argc, argv, i));
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--input") == 0)
+        {
+            options.input_file = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--perfcounters") == 0)
+        {
+            options.perfcounters = 1;
+        }
+        else if (strcmp(argv[i], "--bench-suite") == 0)
+        {
+            options.bench_suite = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--bench-baseline") == 0)
+        {
+            options.bench_baseline = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--bench-threshold") == 0)
+        {
+            const char *percent = option_value(argc, argv, i);
+            char *end;
+            options.bench_threshold = (int)strtol(percent, &end, 10);
+            if (*end != '\0' || options.bench_threshold < 0)
+            {
+                fprintf(stderr, "[ERROR]: Option '%s' expects a percentage, got '%s'.\n", argv[i], percent);
+                exit(1);
+            }
+            i++; // Skip the value
+        }
+        else if (strcmp(argv[i], "--bench-corpus") == 0)
+        {
+            options.bench_corpus = option_value(argc, argv, i);
+            i++; // Skip the value
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            fprintf(stderr, "[ERROR]: Unknown option '%s'.\n", argv[i]);
+            exit(1);
+        }
+        else
+        {
+            argv[remaining++] = argv[i];
+        }
+    }
+    return remaining;
+}
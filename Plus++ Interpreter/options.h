@@ -0,0 +1,42 @@
+// options.h
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Settings given on the command line with "--name value" arguments
+typedef struct
+{
+    const char *result_cache_dir; // Directory of the whole-program result cache, NULL if disabled
+    long long result_cache_size;  // Maximum total size of the result cache in bytes
+    const char *checkpoint_file;  // File that periodically receives the execution state, NULL if disabled
+    int checkpoint_interval;      // Seconds between two checkpoints
+    const char *resume_file;      // Checkpoint to continue from instead of starting the program, NULL if none
+    int compile_threshold;        // Iterations after which a repeat body is compiled, 0 to never compile
+    int emit_c;                   // Translate the program to C instead of running it
+    int threads;                  // Threads for big number multiplication, 0 for one per processor
+    int bench_multiply;           // Time the multiplication algorithms instead of running a program
+    int bench_kernels;            // Time the big number and output kernels instead of running a program
+    const char *params_file;      // CSV file with one parameter set per row to run the program with, NULL if none
+    int parallel;                 // Run independent top-level loops in parallel processes
+    const char *bench_suite;      // JSON file for the results of the benchmark suite, NULL to run a program instead
+    const char *bench_baseline;   // Earlier benchmark results to compare with, NULL if none
+    int bench_threshold;          // Percentage by which a benchmark metric may get worse before it is a regression
+    const char *bench_corpus;     // Directory to save the generated benchmark scripts in, NULL if they are not saved
+    int profile;                  // Time every statement and report the hot spots after the run
+    int trace_level;              // Detail of the trace on stderr (TRACE_OFF to TRACE_VERBOSE)
+    int trace_categories;         // Categories traced (TRACE_LEX, TRACE_PARSE, TRACE_EXEC, TRACE_IO)
+    const char *trace_file;       // File receiving Chrome trace events, NULL if none
+    const char *metrics_file;     // File receiving the runtime metrics (JSON, or Prometheus text for .prom), NULL if none
+    int metrics_interval;         // Seconds between two writes of the metrics file during a run
+    int perfcounters;             // Read hardware performance counters around the phases and report them at exit
+    long long max_memory;         // Cap on the memory of tokens, tables and big numbers in bytes, 0 for none
+    const char *input_file;       // File the read statements take their numbers from, NULL for stdin
+    int check_edits;              // Random edits to check the incremental lexer and parser with, 0 to run the program
+} Options;
+
+// Global options of the current run
+extern Options options;
+
+// Parses the "--name value" arguments and removes them from argv. Returns the new argument count.
+int parse_options(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output.h"
+
+// Buffer for the program output; filled by write statements and emptied by output_flush()
+char output_buffer[OUTPUT_BUFFER_SIZE];
+size_t output_length = 0;
+long long output_bytes = 0;
+long long output_flushes = 0;
+
+// File the output goes to instead of stdout, NULL for stdout
+FILE *output_stream = NULL;
+
+// Optional file that receives a copy of the output (used by the result cache)
+FILE *output_capture = NULL;
+
+void (*output_flush_hook)(int starting) = NULL;
+
+// Function to write the buffered output to stdout and the capture file
+void output_flush()
+{
+    if (output_length == 0)
+        return;
+
+    if (output_flush_hook)
+        output_flush_hook(1);
+    fwrite(output_buffer, 1, output_length, output_stream ? output_stream : stdout);
+    output_flushes++;
+    if (output_capture)
+    {
+        fwrite(output_buffer, 1, output_length, output_capture);
+    }
+    output_length = 0;
+    if (output_flush_hook)
+        output_flush_hook(0);
+}
+
+// Function to redirect the output to a file
+void output_set_stream(FILE *file)
+{
+    output_flush();
+    output_stream = file;
+}
+
+// Function to append bytes to the output buffer, flushing it whenever it is full
+void output_write(const char *data, size_t size)
+{
+    output_bytes += size;
+
+    while (size > 0)
+    {
+        if (output_length == OUTPUT_BUFFER_SIZE)
+        {
+            output_flush();
+        }
+
+        size_t chunk = OUTPUT_BUFFER_SIZE - output_length;
+        if (chunk > size)
+            chunk = size;
+
+        memcpy(output_buffer + output_length, data, chunk);
+        output_length += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+// Function to append a string to the output
+void output_string(const char *s)
+{
+    output_write(s, strlen(s));
+}
+
+// Function to append a number to the output
+void output_number(long long value)
+{
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%lld", value);
+    output_write(text, len);
+}
+
+// Function to append a big integer to the output. Values that fit in a long long take the fast path.
+void output_bigint(const BigInt *value)
+{
+    long long small;
+    if (bigint_to_ll(value, &small))
+    {
+        output_number(small);
+        return;
+    }
+
+    char *text = malloc(bigint_decimal_size(value));
+    size_t len = bigint_to_decimal(value, text);
+    output_write(text, len);
+    free(text);
+}
+
+// Function to start or stop copying the output to a file. Pending output is flushed first so only new output is copied.
+void output_set_capture(FILE *file)
+{
+    output_flush();
+    output_capture = file;
+}
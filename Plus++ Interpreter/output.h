@@ -0,0 +1,44 @@
+// output.h
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include "bigint.h"
+
+// Size of the buffer collecting program output before it is written to stdout
+#define OUTPUT_BUFFER_SIZE 65536
+
+// Total number of bytes the program has written so far
+extern long long output_bytes;
+
+// Number of times the output buffer has been written out
+extern long long output_flushes;
+
+// Function called with 1 before and 0 after each write of the output buffer, NULL if none (used to time the writes)
+extern void (*output_flush_hook)(int starting);
+
+// Number of bytes currently waiting in the output buffer
+extern size_t output_length;
+
+// Appends raw bytes to the program output
+void output_write(const char *data, size_t size);
+
+// Appends a string to the program output
+void output_string(const char *s);
+
+// Appends the decimal representation of a number to the program output
+void output_number(long long value);
+
+// Appends the decimal representation of a big integer to the program output
+void output_bigint(const BigInt *value);
+
+// Writes all buffered output to stdout or the output stream (and to the capture file, if any)
+void output_flush();
+
+// Sends the output to the given file from now on instead of stdout (NULL goes back to stdout); flushes first
+void output_set_stream(FILE *file);
+
+// Copies everything written from now on to the given file as well (NULL stops capturing)
+void output_set_capture(FILE *file);
+
+#endif
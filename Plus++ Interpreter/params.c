@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+#include "params.h"
+#include "cache.h"
+#include "error.h"
+#include "interpreter.h"
+#include "ntt.h"
+#include "options.h"
+#include "output.h"
+#include "input.h"
+#include "trace.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+Parameter parameters[MAX_PARAMETERS];
+int parameter_count = 0;
+
+// Function to check that a name can be a variable name
+int is_parameter_name(const char *name)
+{
+    if (!isalpha((unsigned char)name[0]) && name[0] != '_')
+        return 0;
+    for (const char *p = name; *p; p++)
+    {
+        if (!isalnum((unsigned char)*p) && *p != '_')
+            return 0;
+    }
+    return strlen(name) < sizeof(parameters[0].name);
+}
+
+// Function to bind a variable to a value
+int bind_parameter(const char *name, const char *value)
+{
+    if (!is_parameter_name(name))
+        return 0;
+
+    int i = 0;
+    while (i < parameter_count && strcmp(parameters[i].name, name) != 0)
+        i++;
+    if (i == MAX_PARAMETERS)
+        return 0;
+
+    BigInt parsed = {0};
+    if (!bigint_parse(&parsed, value))
+    {
+        bigint_free(&parsed);
+        return 0;
+    }
+
+    if (i == parameter_count)
+    {
+        strcpy(parameters[i].name, name);
+        parameter_count++;
+    }
+    bigint_copy(&parameters[i].value, &parsed);
+    bigint_free(&parsed);
+    return 1;
+}
+
+// Function to look up the value bound to a variable
+const BigInt *parameter_value(const char *name)
+{
+    for (int i = 0; i < parameter_count; i++)
+    {
+        if (strcmp(parameters[i].name, name) == 0)
+            return &parameters[i].value;
+    }
+    return NULL;
+}
+
+// Function to look up the value bound to a variable that is being declared, and expect its default
+const BigInt *declare_parameter(const char *name)
+{
+    for (int i = 0; i < parameter_count; i++)
+    {
+        if (strcmp(parameters[i].name, name) == 0)
+        {
+            parameters[i].default_pending = 1;
+            return &parameters[i].value;
+        }
+    }
+    return NULL;
+}
+
+// Function to check whether an assignment is the default of a bound variable, consuming it
+int skip_parameter_default(const char *name)
+{
+    for (int i = 0; i < parameter_count; i++)
+    {
+        if (strcmp(parameters[i].name, name) == 0)
+        {
+            int pending = parameters[i].default_pending;
+            parameters[i].default_pending = 0;
+            return pending;
+        }
+    }
+    return 0;
+}
+
+// Function to report the bound variables the program does not declare
+int report_undeclared_parameters()
+{
+    int undeclared = 0;
+    for (int i = 0; i < parameter_count; i++)
+    {
+        if (!program_declares(parameters[i].name))
+        {
+            fprintf(stderr, "[ERROR]: Option '--param' binds '%s', which the program does not declare.\n", parameters[i].name);
+            undeclared++;
+        }
+    }
+    return undeclared;
+}
+
+// Function to hash the names and values of the bound variables
+uint64_t hash_parameters(uint64_t hash)
+{
+    for (int i = 0; i < parameter_count; i++)
+    {
+        const BigInt *v = &parameters[i].value;
+        hash = hash_bytes(hash, parameters[i].name, strlen(parameters[i].name) + 1);
+        hash = hash_bytes(hash, &v->negative, sizeof(v->negative));
+        hash = hash_bytes(hash, &v->length, sizeof(v->length));
+        hash = hash_bytes(hash, v->limbs, v->length * sizeof(uint32_t));
+    }
+    return hash;
+}
+
+// Function to split a CSV line in place at its commas, trimming spaces around the fields. Returns the number of fields.
+int split_fields(char *line, char *fields[], int max_fields)
+{
+    int count = 0;
+    char *p = line;
+    while (1)
+    {
+        while (*p == ' ' || *p == '\t')
+            p++;
+        char *start = p;
+        while (*p && *p != ',' && *p != '\r' && *p != '\n')
+            p++;
+        char *end = p;
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t'))
+            end--;
+
+        if (count < max_fields)
+            fields[count] = start;
+        count++;
+
+        int last = *p != ',';
+        *end = '\0';
+        if (last)
+            break;
+        p++;
+    }
+    return count;
+}
+
+// Function to check whether a line has nothing but whitespace
+int is_blank(const char *line)
+{
+    while (*line && isspace((unsigned char)*line))
+        line++;
+    return *line == '\0';
+}
+
+// Function to run the program for one row, with its output going to <name>.<row>.out. Returns 1 if it completed.
+int run_parameter_row(const char *name, int row)
+{
+    char out_file[600];
+    snprintf(out_file, sizeof(out_file), "%s.%d.out", name, row);
+    FILE *out = fopen(out_file, "wb");
+    if (!out)
+    {
+        fprintf(stderr, "[ERROR]: Could not create '%s'.\n", out_file);
+        return 0;
+    }
+
+    output_set_stream(out);
+    input_close(); // Every row reads the input from the start
+
+    // An error stops this row only
+    jmp_buf recovery;
+    int completed = 0;
+    error_recovery = &recovery;
+    if (setjmp(recovery) == 0)
+    {
+        interpret();
+        completed = 1;
+    }
+    error_recovery = NULL;
+
+    output_set_stream(NULL);
+    fclose(out);
+    if (!completed)
+        fprintf(stderr, "[ERROR]: Row %d stopped with an error.\n", row);
+    return completed;
+}
+
+// Function to run the rows from first to count with the given step, binding each row's values first.
+// Returns the number of rows that failed.
+int run_row_range(const char *name, char **values, int columns, char names[][64], int first, int count, int step)
+{
+    int failed = 0;
+    for (int row = first; row < count; row += step)
+    {
+        for (int c = 0; c < columns; c++)
+            bind_parameter(names[c], values[row * columns + c]); // Validated while reading the file
+        failed += !run_parameter_row(name, row + 1);
+    }
+    return failed;
+}
+
+// Function to run the program once per row of a parameter file. Rows are independent, so on POSIX systems they are
+// spread over one worker process per processor (or --threads); each worker inherits the parsed program.
+int run_parameter_rows(const char *csv_file, const char *name)
+{
+    FILE *csv = fopen(csv_file, "r");
+    if (!csv)
+    {
+        fprintf(stderr, "[ERROR]: Could not open parameter file '%s'.\n", csv_file);
+        exit(1);
+    }
+
+    char *line = malloc(MAX_PARAMETER_LINE);
+    char *fields[MAX_PARAMETERS];
+    char names[MAX_PARAMETERS][64];
+    int columns = 0, line_number = 0;
+
+    // Header: the names of the variables to bind
+    while (columns == 0 && fgets(line, MAX_PARAMETER_LINE, csv))
+    {
+        line_number++;
+        if (is_blank(line))
+            continue;
+        columns = split_fields(line, fields, MAX_PARAMETERS);
+        if (columns > MAX_PARAMETERS)
+        {
+            fprintf(stderr, "[ERROR] (%s, line %d): More than %d parameters.\n", csv_file, line_number, MAX_PARAMETERS);
+            exit(1);
+        }
+        for (int c = 0; c < columns; c++)
+        {
+            if (!is_parameter_name(fields[c]))
+            {
+                fprintf(stderr, "[ERROR] (%s, line %d): '%s' is not a variable name.\n", csv_file, line_number, fields[c]);
+                exit(1);
+            }
+            strcpy(names[c], fields[c]);
+        }
+    }
+
+    // A column the program never declares would be ignored in every row
+    int undeclared = 0;
+    for (int c = 0; c < columns; c++)
+    {
+        if (!program_declares(names[c]))
+        {
+            fprintf(stderr, "[ERROR] (%s, line %d): Column '%s' names a variable the program does not declare.\n",
+                    csv_file, line_number, names[c]);
+            undeclared++;
+        }
+    }
+    if (undeclared > 0)
+        exit(1);
+
+    // Rows: read and check them all before anything runs, so a typo does not surface halfway through a sweep
+    char **values = NULL;
+    int rows = 0, capacity = 0;
+    while (fgets(line, MAX_PARAMETER_LINE, csv))
+    {
+        line_number++;
+        if (is_blank(line))
+            continue;
+        if (split_fields(line, fields, MAX_PARAMETERS) != columns)
+        {
+            fprintf(stderr, "[ERROR] (%s, line %d): Expected %d values.\n", csv_file, line_number, columns);
+            exit(1);
+        }
+
+        if (rows == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            values = realloc(values, (size_t)capacity * columns * sizeof(char *));
+        }
+        for (int c = 0; c < columns; c++)
+        {
+            BigInt check = {0};
+            if (!bigint_parse(&check, fields[c]))
+            {
+                fprintf(stderr, "[ERROR] (%s, line %d): '%s' is not an integer.\n", csv_file, line_number, fields[c]);
+                exit(1);
+            }
+            bigint_free(&check);
+            values[rows * columns + c] = strdup(fields[c]);
+        }
+        rows++;
+    }
+    fclose(csv);
+    free(line);
+
+    int failed = 0;
+    int workers = options.threads > 0 ? options.threads : processor_count();
+    if (workers > rows)
+        workers = rows;
+
+#ifndef _WIN32
+    if (workers > 1)
+    {
+        pid_t *pids = malloc(workers * sizeof(pid_t));
+        output_flush();
+        fflush(stdout);
+        fflush(stderr);
+
+        for (int w = 0; w < workers; w++)
+        {
+            pids[w] = fork();
+            if (pids[w] == 0)
+            {
+                detach_tracing();
+                options.metrics_file = NULL; // The metrics file belongs to the parent as well
+                int worker_failed = run_row_range(name, values, columns, names, w, rows, workers);
+                _exit(worker_failed > 255 ? 255 : worker_failed);
+            }
+            if (pids[w] < 0)
+                failed += run_row_range(name, values, columns, names, w, rows, workers); // Could not fork: run them here
+        }
+
+        for (int w = 0; w < workers; w++)
+        {
+            int status;
+            if (pids[w] <= 0)
+                continue;
+            if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status))
+                failed++; // The worker crashed; count it as one failure
+            else
+                failed += WEXITSTATUS(status);
+        }
+        free(pids);
+    }
+    else
+#endif
+    {
+        failed = run_row_range(name, values, columns, names, 0, rows, 1);
+    }
+
+    for (int i = 0; i < rows * columns; i++)
+        free(values[i]);
+    free(values);
+    return failed;
+}
@@ -0,0 +1,52 @@
+// params.h
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stdint.h>
+#include "bigint.h"
+
+// Maximum number of variables that can be bound from the command line
+#define MAX_PARAMETERS 64
+
+// Longest line of a parameter file
+#define MAX_PARAMETER_LINE 65536
+
+// A variable bound with --param or a --params column: it starts with this value instead of 0, and the
+// program's own top-level "name := constant;" default for it is skipped
+typedef struct
+{
+    char name[64];
+    BigInt value;
+    int default_pending; // 1 from the declaration of the variable until its default has been skipped
+} Parameter;
+
+extern Parameter parameters[MAX_PARAMETERS];
+extern int parameter_count;
+
+// Binds a variable to a value given as a decimal string, replacing an earlier binding of the same name.
+// Returns 0 if the name or the value is not valid.
+int bind_parameter(const char *name, const char *value);
+
+// Returns the value bound to a variable, NULL if it is not bound
+const BigInt *parameter_value(const char *name);
+
+// Returns the value bound to a variable that is being declared, NULL if it is not bound. The next top-level
+// constant assignment to the variable becomes its default.
+const BigInt *declare_parameter(const char *name);
+
+// Returns 1 if a top-level constant assignment to a variable is the default its parameter replaces: the first one
+// after the declaration. Later assignments run as written.
+int skip_parameter_default(const char *name);
+
+// Reports every variable bound with --param that the program never declares, since its value would be ignored
+// (most likely the name is misspelt). Returns the number of such variables.
+int report_undeclared_parameters();
+
+// Mixes the bound values into a program hash, so cached results of different parameter sets are kept apart
+uint64_t hash_parameters(uint64_t hash);
+
+// Runs the parsed program once per row of a CSV file whose header names the variables to bind.
+// The output of row N (counting from 1) goes to <name>.N.out. Returns the number of rows that stopped with an error.
+int run_parameter_rows(const char *csv_file, const char *name);
+
+#endif
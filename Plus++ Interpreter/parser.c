@@ -3,9 +3,9 @@
 #include <stdlib.h>
 #include "parser.h"
 #include "lexer.h"
-
-// Forward declaration of the main parsing function for statements
-void parse_statement();
+#include "error.h"
+#include "module.h"
+#include "trace.h"
 
 // Keeps track of the current token index
 int current = 0;
@@ -50,6 +50,14 @@ Token *peek()
     return NULL;
 }
 
+// Function to peek at the token after the current one, NULL if there is none
+Token *peek_next()
+{
+    if (current + 1 < token_count)
+        return &token_list[current + 1];
+    return NULL;
+}
+
 // Function to advance to the next token and returns the current one
 Token *advance()
 {
@@ -144,7 +152,7 @@ void expect(TokenType type, const char *val)
                 t ? t->value : "EOF");
 
         // Exit the program due to syntax error
-        exit(1);
+        error_exit();
     }
 }
 
@@ -182,7 +190,7 @@ void parse_assignment()
 
         // Report a syntax error if value is missing or invalid
         fprintf(stderr, "[ERROR] (line %d): Expected int or identifier in assignment.\n", err_line);
-        exit(1);
+        error_exit();
     }
 
     // Expect semicolon at the end of the statement
@@ -215,7 +223,7 @@ void parse_increment()
 
         // Print syntax error message
         fprintf(stderr, "[ERROR] (line %d): Expected int or identifier in increment.\n", err_line);
-        exit(1);
+        error_exit();
     }
 
     // Expect a semicolon to terminate the statement
@@ -248,7 +256,60 @@ void parse_decrement()
 
         // Report a syntax error for invalid decrement value
         fprintf(stderr, "[ERROR]: (line %d): Expected int or identifier in decrement.\n", err_line);
-        exit(1);
+        error_exit();
+    }
+
+    // Ensure statement ends with a semicolon
+    expect(TOKEN_ENDOFLINE, NULL);
+}
+
+// Statements written with the arithmetic operators and their names for error messages
+const char *arithmetic_operators[][2] = {
+    {"*=", "multiplication"},
+    {"/=", "division"},
+    {"%=", "modulo"},
+    {"^=", "power"},
+    {NULL, NULL}};
+
+// Function to get the statement name of an arithmetic operator, NULL if the token is not one (or there is no token)
+const char *arithmetic_statement(Token *t)
+{
+    if (!t || t->type != TOKEN_OPERATOR)
+        return NULL;
+    for (int i = 0; arithmetic_operators[i][0]; i++)
+    {
+        if (strcmp(t->value, arithmetic_operators[i][0]) == 0)
+            return arithmetic_operators[i][1];
+    }
+    return NULL;
+}
+
+// Function to parse arithmetic statements: <identifier> *= <value>; (likewise /=, %= and ^=)
+void parse_arithmetic()
+{
+    // Expect an identifier before the operator
+    expect(TOKEN_IDENTIFIER, NULL);
+
+    // The caller has already checked that one of the arithmetic operators follows
+    const char *statement = arithmetic_statement(advance());
+
+    // Validate the value after the operator (should be int or identifier)
+    Token *t = peek();
+    if (t && (t->type == TOKEN_INTCONST || t->type == TOKEN_IDENTIFIER))
+    {
+        advance(); // Consume the value
+    }
+    else
+    {
+        // Select appropriate line for error reporting
+        int err_line = t ? t->line : last_token_line;
+        if (last_token && t && last_token->line < t->line)
+        {
+            err_line = last_token->line;
+        }
+
+        fprintf(stderr, "[ERROR] (line %d): Expected int or identifier in %s.\n", err_line, statement);
+        error_exit();
     }
 
     // Ensure statement ends with a semicolon
@@ -272,7 +333,7 @@ void parse_write()
         {
             int err_line = last_token_line;
             fprintf(stderr, "[ERROR] (line %d): Unexpected end of input in write statement.\n", err_line);
-            exit(1);
+            error_exit();
         }
 
         if (expect_and)
@@ -300,7 +361,7 @@ void parse_write()
                 // If an invalid token is encountered, report an error
                 fprintf(stderr, "[ERROR] (line %d): Unexpected token '%s' in write statement. Expected string, identifier, or newline.\n",
                         t->line, t->value);
-                exit(1);
+                error_exit();
             }
         }
     }
@@ -309,37 +370,35 @@ void parse_write()
     expect(TOKEN_ENDOFLINE, NULL);
 }
 
-// Function to parse block of statements between { and }
-void parse_block()
+// Function to parse: read <identifier>;
+void parse_read()
 {
-    // Expect the opening block symbol '{'
-    expect(TOKEN_OPENBLOCK, NULL);
+    expect(TOKEN_KEYWORD, "read");
+    expect(TOKEN_IDENTIFIER, NULL);
+    expect(TOKEN_ENDOFLINE, NULL);
+}
 
-    while (1)
+// Function to parse the start of a block of statements between { and }. Its statements and the closing '}' are parsed
+// by parse_statement(). Returns 1 if a block was opened, 0 if an included module was skipped instead.
+int parse_block()
+{
+    // An included module was checked when it was loaded, so it is only skipped
+    Token *open = peek();
+    if (open && open->type == TOKEN_OPENBLOCK && open->value[0])
     {
-        Token *t = peek();
-
-        // If there are no more tokens, it's an unexpected end of input (missing '}')
-        if (!t)
-        {
-            fprintf(stderr, "[ERROR]: Unexpected end of input in block.\n");
-            exit(1);
-        }
-
-        // If the closing block symbol '}' is found, consume it and exit the loop
-        if (t->type == TOKEN_CLOSEBLOCK)
-        {
-            expect(TOKEN_CLOSEBLOCK, NULL);
-            break;
-        }
-
-        // Otherwise, parse the next statement inside the block
-        parse_statement();
+        current = included_module_end(current);
+        last_token = &token_list[current - 1];
+        last_token_line = last_token->line;
+        return 0;
     }
+
+    // Expect the opening block symbol '{'
+    expect(TOKEN_OPENBLOCK, NULL);
+    return 1;
 }
 
-// Function to parse: repeat <value> times { ... } OR single statement
-void parse_repeat()
+// Function to parse: repeat <value> times { ... } OR single statement. Returns 1 if the body is a block that was opened.
+int parse_repeat()
 {
     // Expect "repeat" keyword
     expect(TOKEN_KEYWORD, "repeat");
@@ -353,7 +412,7 @@ void parse_repeat()
     else
     {
         fprintf(stderr, "[ERROR] (line %d): Expected int or identifier after 'repeat'.\n", t ? t->line : -1);
-        exit(1);
+        error_exit();
     }
 
     // Expect the "times" keyword following the count
@@ -363,8 +422,8 @@ void parse_repeat()
     t = peek();
     if (t && t->type == TOKEN_OPENBLOCK)
     {
-        // If it's a block, parse the entire block
-        parse_block();
+        // If it's a block, open it; its statements follow
+        return parse_block();
     }
     else
     {
@@ -372,7 +431,7 @@ void parse_repeat()
         if (!t)
         {
             fprintf(stderr, "[ERROR]: Unexpected end of input after 'repeat times'.\n");
-            exit(1);
+            error_exit();
         }
 
         // Handle inline "write" statement
@@ -380,59 +439,63 @@ void parse_repeat()
         {
             parse_write();
         }
+        // Handle inline "read" statement
+        else if (t->type == TOKEN_KEYWORD && strcmp(t->value, "read") == 0)
+        {
+            parse_read();
+        }
         // Handle assignment, increment, or decrement statements
         else if (t->type == TOKEN_IDENTIFIER)
         {
             // Look ahead to determine what kind of statement this is
-            Token *lookahead = &token_list[current + 1];
-            if (lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, ":=") == 0)
+            Token *lookahead = peek_next();
+            if (lookahead && lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, ":=") == 0)
             {
-                parse_assignment();
-                expect(TOKEN_ENDOFLINE, NULL); // Ensure line ends properly
+                parse_assignment(); // Also consumes the semicolon
             }
-            else if (lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, "+=") == 0)
+            else if (lookahead && lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, "+=") == 0)
             {
                 parse_increment();
-                expect(TOKEN_ENDOFLINE, NULL);
             }
-            else if (lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, "-=") == 0)
+            else if (lookahead && lookahead->type == TOKEN_OPERATOR && strcmp(lookahead->value, "-=") == 0)
             {
                 parse_decrement();
-                expect(TOKEN_ENDOFLINE, NULL);
+            }
+            else if (arithmetic_statement(lookahead))
+            {
+                parse_arithmetic();
             }
             else
             {
                 fprintf(stderr, "[ERROR] (line %d): Unexpected token after 'repeat times'.\n", t->line);
-                exit(1);
+                error_exit();
             }
         }
         else
         {
             // If token is not one of the expected types
             fprintf(stderr, "[ERROR] (line %d): Unexpected token after 'repeat times'.\n", t->line);
-            exit(1);
+            error_exit();
         }
     }
+    return 0;
 }
 
-// Function of debug utility to print all tokens
+// Function of debug utility to print all tokens (to stderr, so the program output stays clean)
 void debug_tokens()
 {
-    printf("\n--- Token List ---\n");
+    fprintf(stderr, "\n--- Token List ---\n");
     for (int i = 0; i < token_count; i++)
     {
-        printf("Line %d: %-15s %s\n", token_list[i].line, token_type_to_string(token_list[i].type), token_list[i].value);
+        fprintf(stderr, "Line %d: %-15s %s\n", token_list[i].line, token_type_to_string(token_list[i].type), token_list[i].value);
     }
-    printf("------------------\n");
+    fprintf(stderr, "------------------\n");
 }
 
-// Function to parse a single statement
-void parse_statement()
+// Function to parse a statement up to its body: a simple statement completely, a block or repeat loop up to the
+// statements of its block. Returns the number of blocks opened (0 or 1).
+int parse_statement_start(Token *t)
 {
-    Token *t = peek();
-    if (!t)
-        return; // No more tokens to parse
-
     // Handle keyword-based statements
     if (t->type == TOKEN_KEYWORD)
     {
@@ -446,16 +509,21 @@ void parse_statement()
             // Output statement
             parse_write();
         }
+        else if (strcmp(t->value, "read") == 0)
+        {
+            // Input statement
+            parse_read();
+        }
         else if (strcmp(t->value, "repeat") == 0)
         {
             // Looping statement
-            parse_repeat();
+            return parse_repeat();
         }
         else
         {
             // Unknown keyword
             fprintf(stderr, "[ERROR] (line %d): Unexpected keyword '%s'\n", t->line, t->value);
-            exit(1);
+            error_exit();
         }
     }
 
@@ -463,8 +531,8 @@ void parse_statement()
     else if (t->type == TOKEN_IDENTIFIER)
     {
         // Look ahead to determine which type of operation this is
-        Token *lookahead = &token_list[current + 1];
-        if (lookahead->type == TOKEN_OPERATOR)
+        Token *lookahead = peek_next();
+        if (lookahead && lookahead->type == TOKEN_OPERATOR)
         {
             if (strcmp(lookahead->value, ":=") == 0)
             {
@@ -481,18 +549,23 @@ void parse_statement()
                 // Decrement
                 parse_decrement();
             }
+            else if (arithmetic_statement(lookahead))
+            {
+                // Multiplication, division, modulo or power
+                parse_arithmetic();
+            }
             else
             {
                 // Unknown operator after identifier
                 fprintf(stderr, "[ERROR] (line %d): Unexpected operator '%s'\n", lookahead->line, lookahead->value);
-                exit(1);
+                error_exit();
             }
         }
         else
         {
             // Identifier not followed by valid operator
             fprintf(stderr, "[ERROR] (line %d): Unexpected token '%s'\n", t->line, t->value);
-            exit(1);
+            error_exit();
         }
     }
 
@@ -500,32 +573,99 @@ void parse_statement()
     else if (t->type == TOKEN_OPENBLOCK)
     {
         // Nested block statement
-        parse_block();
+        return parse_block();
     }
 
     // Unmatched closing block
     else if (t->type == TOKEN_CLOSEBLOCK)
     {
         fprintf(stderr, "[ERROR] (line %d): Unexpected '}'\n", t->line);
-        exit(1);
+        error_exit();
     }
 
     // Any other unexpected token
     else
     {
         fprintf(stderr, "[ERROR] (line %d): Unexpected token '%s'\n", t->line, t->value);
-        exit(1);
+        error_exit();
     }
+    return 0;
 }
 
-// Function to parse entire token stream
-void parse()
+// Function to parse a single statement. Nested blocks are not parsed recursively: only the number of blocks that are
+// still open is kept, since a block needs nothing else once it is open, so nesting is not limited by the C stack.
+void parse_statement()
+{
+    int depth = 0; // Blocks opened by this statement and not closed yet
+
+    do
+    {
+        Token *t = peek();
+
+        // No more tokens to parse; inside a block, it's an unexpected end of input (missing '}')
+        if (!t)
+        {
+            if (depth > 0)
+            {
+                fprintf(stderr, "[ERROR]: Unexpected end of input in block.\n");
+                error_exit();
+            }
+            return;
+        }
+
+        // If the closing block symbol '}' is found, consume it and leave the innermost block
+        if (depth > 0 && t->type == TOKEN_CLOSEBLOCK)
+        {
+            expect(TOKEN_CLOSEBLOCK, NULL);
+            depth--;
+            continue;
+        }
+
+        // Otherwise, parse the next statement (inside the innermost block, if any)
+        depth += parse_statement_start(t);
+    } while (depth > 0);
+}
+
+// Function to check the syntax of the statements from the current token to the end
+void parse_statements()
 {
     while (current < token_count)
     {
         // Parse a single statement at the current token position
         parse_statement();
     }
-    // If all tokens have been parsed without errors, print success message
-    printf("Syntax analysis completed successfully.\n");
+}
+
+// Function to parse the statements of tokens [current, end) the way they are parsed inside a program whose blocks
+// may have been opened before them or stay open after them
+int parse_range(int end, int *lowest)
+{
+    int depth = 0; // Blocks opened minus blocks closed since the start of the range
+    *lowest = 0;
+    last_token = NULL;
+
+    while (current < end)
+    {
+        Token *t = peek();
+
+        // A '}' may close a block opened before the range; whether one was open is up to the caller
+        if (t->type == TOKEN_CLOSEBLOCK)
+        {
+            expect(TOKEN_CLOSEBLOCK, NULL);
+            if (--depth < *lowest)
+                *lowest = depth;
+            continue;
+        }
+        depth += parse_statement_start(t);
+    }
+    return depth;
+}
+
+// Function to parse entire token stream
+void parse()
+{
+    parse_statements();
+    // If all tokens have been parsed without errors, say so in the trace; stdout is left to the program
+    if (TRACING(TRACE_PARSE, TRACE_INFO))
+        trace_message(TRACE_PARSE, "syntax analysis completed successfully");
 }
@@ -8,4 +8,13 @@ void parse();
 // Parses a single statement from the token stream
 void parse_statement();
 
+// Parses the statements from the current token to the end of the token stream, without reporting success
+void parse_statements();
+
+// Parses the statements from the current token up to end on their own, for re-checking part of a program that was
+// valid: blocks may close that were opened before the range, and stay open after it. Returns the number of blocks
+// opened minus closed, and stores the lowest that number reached in lowest. A statement that runs past end is parsed
+// to its end, leaving current after end.
+int parse_range(int end, int *lowest);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "perfcounters.h"
+#include "metrics.h"
+#include "output.h"
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+int perfcounters = 0;
+
+// Names of the events, in the order of their indices
+const char *perfcounter_names[PERF_EVENTS] = {"cpu_ns", "cycles", "instructions", "branch_misses", "l1d_read_misses",
+                                              "llc_read_misses"};
+
+// File descriptors of the hardware counters, -1 for the ones that are not available
+int perfcounter_fds[PERF_EVENTS] = {-1, -1, -1, -1, -1, -1};
+
+// Error of the last counter that could not be opened
+int perfcounter_error = 0;
+
+// Counts of each phase and the counter values at the start of the phases that are running
+long long phase_events[PHASE_COUNT][PERF_EVENTS];
+long long phase_event_start[PHASE_COUNT][PERF_EVENTS];
+
+// Returns the CPU time of the process in nanoseconds
+long long cpu_time_ns()
+{
+#ifdef _WIN32
+    return (long long)((double)clock() * 1e9 / CLOCKS_PER_SEC);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+#ifdef __linux__
+// Function to open one counter of this process and the threads it starts; returns -1 if it is not available
+int open_perfcounter(unsigned type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1; // Counting user space only works with the default perf_event_paranoid setting
+    attr.exclude_hv = 1;
+    attr.inherit = 1; // Include the multiplication threads
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0)
+        perfcounter_error = errno;
+    return fd;
+}
+
+// Returns the value of a counter, scaled up if the kernel had to share the hardware with other counters
+long long read_perfcounter(int fd)
+{
+    unsigned long long data[3]; // Value, time enabled, time running
+    if (read(fd, data, sizeof(data)) != sizeof(data))
+        return -1;
+    if (data[2] == 0)
+        return 0;
+    if (data[2] < data[1])
+        return (long long)((double)data[0] * data[1] / data[2]);
+    return (long long)data[0];
+}
+#endif
+
+// Function to read all counters
+void read_perfcounters(long long values[PERF_EVENTS])
+{
+    values[PERF_CPU_NS] = cpu_time_ns();
+    for (int e = 1; e < PERF_EVENTS; e++)
+    {
+#ifdef __linux__
+        values[e] = perfcounter_fds[e] >= 0 ? read_perfcounter(perfcounter_fds[e]) : -1;
+#else
+        values[e] = -1;
+#endif
+    }
+}
+
+// Function to start counting a phase
+void perfcounters_phase_begin(int phase)
+{
+    read_perfcounters(phase_event_start[phase]);
+}
+
+// Function to add the counts since the start of a phase to it
+void perfcounters_phase_end(int phase)
+{
+    long long now[PERF_EVENTS];
+    read_perfcounters(now);
+    for (int e = 0; e < PERF_EVENTS; e++)
+    {
+        if (now[e] < 0 || phase_event_start[phase][e] < 0)
+            phase_events[phase][e] = -1;
+        else if (phase_events[phase][e] >= 0)
+            phase_events[phase][e] += now[e] - phase_event_start[phase][e];
+    }
+}
+
+// Function to print the counts of the phases
+void report_perfcounters()
+{
+    output_flush(); // Keep the program output ahead of the report (and count its last write)
+    fflush(stdout);
+
+    // Phases still running when the program stopped with an error end here
+    for (int p = 0; p < PHASE_COUNT; p++)
+        metrics_phase_end(p);
+
+    fprintf(stderr, "\n--- Performance counters ---\n");
+    fprintf(stderr, "%-10s %10s %10s %14s %14s %6s %12s %12s %12s\n", "phase", "wall ms", "cpu ms", "cycles",
+            "instructions", "IPC", "br misses", "L1D misses", "LLC misses");
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        const long long *v = phase_events[p];
+        fprintf(stderr, "%-10s %10.3f %10.3f", metrics_phase_names[p], phase_time(p) * 1e3, v[PERF_CPU_NS] / 1e6);
+        for (int e = 1; e < PERF_EVENTS; e++)
+        {
+            if (v[e] < 0)
+                fprintf(stderr, " %*s", e <= 2 ? 14 : 12, "-");
+            else
+                fprintf(stderr, " %*lld", e <= 2 ? 14 : 12, v[e]);
+            if (e == 2) // IPC follows the instructions
+            {
+                if (v[1] > 0 && v[2] >= 0)
+                    fprintf(stderr, " %6.2f", (double)v[2] / v[1]);
+                else
+                    fprintf(stderr, " %6s", "-");
+            }
+        }
+        fputc('\n', stderr);
+    }
+    fprintf(stderr, "(output is the writing of the output buffer, which is part of interpret)\n");
+}
+
+// Function to open the counters
+void enable_perfcounters()
+{
+#ifdef __linux__
+    int opened = 0;
+    const unsigned long long cache_read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    perfcounter_fds[1] = open_perfcounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perfcounter_fds[2] = open_perfcounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perfcounter_fds[3] = open_perfcounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    perfcounter_fds[4] = open_perfcounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cache_read_miss);
+    perfcounter_fds[5] = open_perfcounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cache_read_miss);
+    for (int e = 1; e < PERF_EVENTS; e++)
+        opened += perfcounter_fds[e] >= 0;
+    if (opened == 0)
+        fprintf(stderr, "[perfcounters] Hardware counters are not available (%s); only CPU time is reported.\n",
+                strerror(perfcounter_error));
+    else if (opened < PERF_EVENTS - 1)
+        fprintf(stderr, "[perfcounters] %d of %d hardware counters are not available (%s).\n", PERF_EVENTS - 1 - opened,
+                PERF_EVENTS - 1, strerror(perfcounter_error));
+#else
+    fprintf(stderr, "[perfcounters] Hardware counters need Linux; only CPU time is reported.\n");
+#endif
+
+    // Phases report the counters that are not available as missing rather than 0
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        for (int e = 1; e < PERF_EVENTS; e++)
+            phase_events[p][e] = perfcounter_fds[e] >= 0 ? 0 : -1;
+    }
+
+    perfcounters = 1;
+    measure_output_phase();
+    atexit(report_perfcounters);
+}
+
+// Function to write the counts as a JSON member "perf_counters" (followed by a comma)
+void write_perfcounters_json(FILE *file)
+{
+    fprintf(file, "  \"perf_counters\": {");
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        fprintf(file, "%s\n    \"%s\": {", p ? "," : "", metrics_phase_names[p]);
+        for (int e = 0; e < PERF_EVENTS; e++)
+        {
+            if (phase_events[p][e] < 0)
+                fprintf(file, "%s\"%s\": null", e ? ", " : "", perfcounter_names[e]);
+            else
+                fprintf(file, "%s\"%s\": %lld", e ? ", " : "", perfcounter_names[e], phase_events[p][e]);
+        }
+        fputc('}', file);
+    }
+    fprintf(file, "\n  },\n");
+}
+
+// Function to write the counts as Prometheus samples; unavailable counters are left out
+void write_perfcounters_prometheus(FILE *file)
+{
+    fprintf(file, "# HELP ppp_perf_events_total CPU time in nanoseconds and hardware events by phase.\n");
+    fprintf(file, "# TYPE ppp_perf_events_total counter\n");
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        for (int e = 0; e < PERF_EVENTS; e++)
+        {
+            if (phase_events[p][e] >= 0)
+                fprintf(file, "ppp_perf_events_total{phase=\"%s\",event=\"%s\"} %lld\n", metrics_phase_names[p],
+                        perfcounter_names[e], phase_events[p][e]);
+        }
+    }
+}
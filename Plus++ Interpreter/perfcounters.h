@@ -0,0 +1,27 @@
+// perfcounters.h
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <stdio.h>
+
+// Counted events: CPU time (a software clock, always available), then the hardware counters read through
+// perf_event_open on Linux (cycles, instructions, branch misses, L1 data cache and last-level cache read misses)
+#define PERF_CPU_NS 0
+#define PERF_EVENTS 6
+
+// 1 when the counters are read around the phases (--perfcounters)
+extern int perfcounters;
+
+// Opens the counters. Hardware counters that cannot be opened (no PMU, containers, perf_event_paranoid) are left
+// out with a note on stderr; CPU time is measured in any case. The report is printed to stderr at exit.
+void enable_perfcounters();
+
+// Start and end of a phase (a MetricsPhase); the counts in between are added to it
+void perfcounters_phase_begin(int phase);
+void perfcounters_phase_end(int phase);
+
+// Write the counts of every phase into the metrics file, as JSON members or Prometheus samples
+void write_perfcounters_json(FILE *file);
+void write_perfcounters_prometheus(FILE *file);
+
+#endif
@@ -1,8 +1,28 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "file_utils.h"
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
+#include "cache.h"
+#include "options.h"
+#include "output.h"
+#include "checkpoint.h"
+#include "repl.h"
+#include "emit_c.h"
+#include "ntt.h"
+#include "bench.h"
+#include "params.h"
+#include "suite.h"
+#include "profile.h"
+#include "trace.h"
+#include "metrics.h"
+#include "status.h"
+#include "perfcounters.h"
+#include "memory.h"
+#include "input.h"
+#include "error.h"
+#include "incremental.h"
 
 void debug_tokens();
 
@@ -10,24 +30,230 @@ int main(int argc, char *argv[])
 {
     char source_file[512];
 
-    // Get the source filename from command line arguments or prompt the user
+    // Handle "--name value" options and keep only the source name in argv
+    argc = parse_options(argc, argv);
+
+    // Large multiplications split their transforms across this many threads
+    ntt_threads = options.threads;
+
+    // Going over the memory cap is an error like any other (the REPL keeps its session after it)
+    memory_limit = options.max_memory;
+    memory_limit_hook = error_exit;
+
+    // Read statements take their numbers from the --input file or stdin
+    input_file = options.input_file;
+
+    // Benchmark mode: time the multiplication algorithms and exit
+    if (options.bench_multiply)
+    {
+        benchmark_multiplication();
+        return 0;
+    }
+    if (options.bench_kernels)
+    {
+        benchmark_kernels();
+        return 0;
+    }
+
+    // Benchmark suite: lex, parse and run the generated corpus, then compare with the baseline if one is given
+    if (options.bench_suite)
+    {
+        int regressions = run_benchmark_suite(options.bench_suite, options.bench_baseline, options.bench_threshold, options.bench_corpus);
+        return regressions > 0;
+    }
+
+    // Make sure buffered program output is written even if the program stops with an error
+    atexit(output_flush);
+
+    // Trace the phases of the run on stderr and/or into a Chrome trace file
+    if (options.trace_level > TRACE_OFF || options.trace_file)
+    {
+        start_tracing(options.trace_level, options.trace_categories, options.trace_file);
+    }
+
+    // Write the runtime metrics periodically and at exit
+    if (options.metrics_file)
+    {
+        start_metrics(options.metrics_file, options.metrics_interval);
+    }
+
+    // Count CPU time and hardware events (cycles, instructions, cache misses) in each phase
+    if (options.perfcounters)
+    {
+        enable_perfcounters();
+    }
+
+    // SIGUSR1 prints where a running program is and how fast it goes, without stopping it
+    enable_status_signal();
+
+    // Without a source file, start the interactive REPL. Its statements come from stdin, so input needs --input.
+    if (argc < 2)
+    {
+        input_stdin_allowed = 0;
+        run_repl();
+        return 0;
+    }
+
+    // Get the source filename from command line arguments
     get_source_filename(argc, argv, source_file, sizeof(source_file));
 
+    // Edit check: apply random edits to the script and compare every incremental update with a full re-check
+    if (options.check_edits)
+        return run_edit_check(source_file, options.check_edits) > 0;
+
     // Open the source file for reading
+    trace_begin(TRACE_IO, TRACE_INFO, "read source");
     FILE *infile = open_source_file(source_file);
 
-    // Tokenize the input source file and output tokens to stdout
-    tokenize(infile, stdout);
-    fclose(infile);
+    // Hash the source so a compiled program cached from the same source can be reused
+    uint64_t source_hash = hash_file(infile);
+    trace_end();
+
+    // Skip tokenizing and parsing entirely if the .pppc cache is valid
+    trace_begin(TRACE_IO, TRACE_INFO, "load program cache");
+    int cached = load_program_cache(source_file, source_hash);
+    trace_end();
+    if (cached)
+    {
+        fclose(infile);
+        if (TRACING(TRACE_IO, TRACE_INFO))
+            trace_message(TRACE_IO, "%d tokens loaded from the program cache", token_count);
+    }
+    else
+    {
+        // Tokenize the input source file (tokens are traced at the verbose level)
+        trace_begin(TRACE_LEX, TRACE_INFO, "lex");
+        metrics_phase_begin(PHASE_TOKENIZE);
+        tokenize(infile, NULL);
+        metrics_phase_end(PHASE_TOKENIZE);
+        trace_end();
+        source_bytes = ftell(infile);
+        fclose(infile);
+        if (TRACING(TRACE_LEX, TRACE_INFO))
+            trace_message(TRACE_LEX, "%d tokens", token_count);
+
+        // Optional: print or inspect tokens for debugging
+        if (TRACING(TRACE_PARSE, TRACE_DEBUG))
+            debug_tokens();
+
+        // Parse the token stream into syntax structures
+        trace_begin(TRACE_PARSE, TRACE_INFO, "parse");
+        metrics_phase_begin(PHASE_PARSE);
+        parse();
+        metrics_phase_end(PHASE_PARSE);
+        trace_end();
+
+        // Store the validated program for the next run
+        trace_begin(TRACE_IO, TRACE_INFO, "save program cache");
+        save_program_cache(source_file, source_hash);
+        trace_end();
+    }
+
+    // A bound variable the program never declares would be ignored, so the run would silently use the defaults
+    if (report_undeclared_parameters() > 0)
+    {
+        return 1;
+    }
+
+    // Ahead-of-time compilation: write <name>.c instead of running the program
+    if (options.emit_c)
+    {
+        char c_file[520];
+        snprintf(c_file, sizeof(c_file), "%s.c", argv[1]);
+        FILE *outfile = fopen(c_file, "w");
+        if (!outfile)
+        {
+            fprintf(stderr, "Could not create '%s'\n", c_file);
+            return 1;
+        }
+        emit_c_program(outfile, source_file);
+        fclose(outfile);
+        fprintf(stderr, "Wrote %s. Build it with: cc -O2 -pthread -o %s %s output.c bigint.c ntt.c memory.c input.c\n", c_file, argv[1], c_file);
+        return 0;
+    }
+
+    // Parameter sweep: run the program once per row of the parameter file, each row into its own output file
+    if (options.params_file)
+    {
+        if (options.checkpoint_file || options.resume_file)
+        {
+            fprintf(stderr, "[ERROR]: --params cannot be combined with checkpoints.\n");
+            return 1;
+        }
+        if (options.profile)
+        {
+            fprintf(stderr, "[ERROR]: --params cannot be combined with --profile.\n");
+            return 1;
+        }
+        if (!options.input_file && program_reads_input())
+        {
+            fprintf(stderr, "[ERROR]: --params needs --input for a program that reads input, so every row can read it.\n");
+            return 1;
+        }
+        trace_begin(TRACE_EXEC, TRACE_INFO, "run parameter rows");
+        int failed = run_parameter_rows(options.params_file, argv[1]);
+        trace_end();
+        return failed > 0;
+    }
+
+    // Profiling: time every statement. Compiled loop bodies have no statement boundaries, so loops stay in the
+    // interpreter, and the program has to run, so the result cache is not used.
+    if (options.profile)
+    {
+        options.compile_threshold = 0;
+        enable_profiling(argv[1]);
+    }
+
+    // Programs without read statements take no input, so the same token stream (and parameters) always produces the
+    // same output (a resumed run only produces part of it, and a program that reads input may not, so they are never cached)
+    int cache_result = options.result_cache_dir && !options.resume_file && !options.profile && !program_reads_input();
+    if (cache_result)
+    {
+        uint64_t program_hash = hash_parameters(hash_token_stream());
+        trace_begin(TRACE_IO, TRACE_INFO, "replay cached result");
+        int replayed = replay_cached_result(options.result_cache_dir, program_hash);
+        trace_end();
+        if (replayed)
+        {
+            complete_metrics();
+            return 0; // Output was served from the cache without executing anything
+        }
+        begin_result_capture(options.result_cache_dir, program_hash);
+    }
 
-    // Optional: print or inspect tokens for debugging
-    debug_tokens();
+    // Interpret the parsed code, or continue a previous run from its checkpoint
+    if (options.resume_file)
+    {
+        trace_begin(TRACE_IO, TRACE_INFO, "load checkpoint");
+        load_checkpoint(options.resume_file);
+        trace_end();
+        trace_begin(TRACE_EXEC, TRACE_INFO, "execute");
+        metrics_phase_begin(PHASE_INTERPRET);
+        run_program();
+        metrics_phase_end(PHASE_INTERPRET);
+        trace_end();
+    }
+    else
+    {
+        trace_begin(TRACE_EXEC, TRACE_INFO, "execute");
+        metrics_phase_begin(PHASE_INTERPRET);
+        interpret();
+        metrics_phase_end(PHASE_INTERPRET);
+        trace_end();
+    }
+    complete_metrics();
 
-    // Parse the token stream into syntax structures
-    parse();
+    // The run is complete, so there is nothing left to resume
+    if (options.checkpoint_file)
+    {
+        finish_checkpoints();
+    }
 
-    // Interpret the parsed code
-    interpret();
+    // Store the output of the completed run in the result cache
+    if (cache_result)
+    {
+        commit_result_capture(options.result_cache_size);
+    }
 
     return 0;
 }
\ No newline at end of file
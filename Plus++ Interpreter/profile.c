@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "profile.h"
+#include "lexer.h"
+#include "interpreter.h"
+#include "output.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// A statement in the context of the loops it runs in. The nodes form a tree: the parent of a statement inside a
+// loop is the node of that loop, and the root (node 0) stands for the top level. Each path from the root is one
+// collapsed stack.
+typedef struct
+{
+    int parent;
+    int token;      // First token of the statement
+    long long self; // Nanoseconds spent in the statement itself
+} ProfileNode;
+
+// Executions of each statement, by its first token
+long long *statement_calls = NULL;
+
+int profiling = 0;
+const char *profile_name = NULL;
+
+// Nodes of the tree, and an open-addressing table finding a node by parent and token
+ProfileNode *profile_nodes = NULL;
+int profile_node_count = 0;
+int profile_node_capacity = 0;
+int *profile_table = NULL; // Node indices, -1 for empty entries
+int profile_table_size = 0;
+
+// Node and start time of the statement being timed
+int profile_node = 0;
+long long profile_start_time = 0;
+
+// Time the clock itself adds to every measurement, subtracted again when a statement is stopped
+long long profile_overhead = 0;
+
+// Returns a monotonic time in nanoseconds
+long long profile_clock()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+// Function to measure the time between two back-to-back clock readings (the smallest of many, which is the cost
+// without interruptions)
+void calibrate_profile_clock()
+{
+    profile_overhead = -1;
+    for (int i = 0; i < 1000; i++)
+    {
+        long long start = profile_clock();
+        long long elapsed = profile_clock() - start;
+        if (profile_overhead < 0 || elapsed < profile_overhead)
+            profile_overhead = elapsed;
+    }
+}
+
+// Returns the slot of the table for a parent and token: the one holding their node or the empty one to put it in
+int profile_slot(int parent, int token)
+{
+    unsigned hash = (unsigned)parent * 2654435761u ^ (unsigned)token * 40503u;
+    int i = hash & (profile_table_size - 1);
+    while (profile_table[i] >= 0)
+    {
+        ProfileNode *n = &profile_nodes[profile_table[i]];
+        if (n->parent == parent && n->token == token)
+            break;
+        i = (i + 1) & (profile_table_size - 1);
+    }
+    return i;
+}
+
+// Function to double the table once it is half full
+void grow_profile_table()
+{
+    free(profile_table);
+    profile_table_size = profile_table_size ? profile_table_size * 2 : 1024;
+    profile_table = malloc(profile_table_size * sizeof(int));
+    for (int i = 0; i < profile_table_size; i++)
+        profile_table[i] = -1;
+    for (int n = 1; n < profile_node_count; n++)
+        profile_table[profile_slot(profile_nodes[n].parent, profile_nodes[n].token)] = n;
+}
+
+// Returns the node of a statement under the given parent, adding it the first time
+int profile_child(int parent, int token)
+{
+    int slot = profile_slot(parent, token);
+    if (profile_table[slot] >= 0)
+        return profile_table[slot];
+
+    if (profile_node_count == profile_node_capacity)
+    {
+        profile_node_capacity *= 2;
+        profile_nodes = realloc(profile_nodes, profile_node_capacity * sizeof(ProfileNode));
+    }
+    int n = profile_node_count++;
+    profile_nodes[n].parent = parent;
+    profile_nodes[n].token = token;
+    profile_nodes[n].self = 0;
+    profile_table[slot] = n;
+
+    if (profile_node_count * 2 > profile_table_size)
+        grow_profile_table();
+    return n;
+}
+
+// Function to start profiling
+void enable_profiling(const char *name)
+{
+    profile_name = name;
+    profile_node_capacity = 256;
+    profile_nodes = malloc(profile_node_capacity * sizeof(ProfileNode));
+    profile_nodes[0].parent = -1;
+    profile_nodes[0].token = -1;
+    profile_nodes[0].self = 0;
+    profile_node_count = 1;
+    grow_profile_table();
+    statement_calls = calloc(token_count + 1, sizeof(long long));
+    calibrate_profile_clock();
+    profiling = 1;
+    atexit(profile_report);
+}
+
+// Function to start timing a statement in the loops of the first frames frames
+void profile_start(int statement, int frames, int execution)
+{
+    int node = 0;
+    for (int i = 0; i < frames; i++)
+    {
+        if (frame_stack[i].count_token >= 0)
+            node = profile_child(node, frame_stack[i].count_token - 1); // The repeat keyword precedes the count
+    }
+    profile_node = profile_child(node, statement);
+    statement_calls[statement] += execution;
+    profile_start_time = profile_clock();
+}
+
+// Function to stop timing the current statement
+void profile_stop()
+{
+    long long elapsed = profile_clock() - profile_start_time - profile_overhead;
+    if (elapsed > 0)
+        profile_nodes[profile_node].self += elapsed;
+}
+
+// Function to describe a statement by its tokens: the header of a loop, "{ }" for a block, otherwise the statement
+// without its semicolon. Characters that separate frames in collapsed stacks are left out.
+void describe_statement(int statement, char *text, size_t size)
+{
+    int end;
+    if (token_list[statement].type == TOKEN_OPENBLOCK)
+        end = statement + 1;
+    else if (token_list[statement].type == TOKEN_KEYWORD && strcmp(token_list[statement].value, "repeat") == 0)
+        end = statement + 3;
+    else
+        end = statement_end(statement) - 1;
+
+    size_t length = 0;
+    text[0] = '\0';
+    for (int i = statement; i < end && length + 1 < size; i++)
+    {
+        const Token *t = &token_list[i];
+        const char *quote = t->type == TOKEN_STRINGCONST ? "\"" : "";
+        length += snprintf(text + length, size - length, "%s%s%s%s", i > statement ? " " : "", quote,
+                           t->type == TOKEN_OPENBLOCK ? "{ }" : t->value, quote);
+    }
+    if (length >= size - 1 && size > 4)
+        strcpy(text + size - 4, "...");
+    for (char *p = text; *p; p++)
+    {
+        if (*p == ';' || *p == '\n' || *p == '\r')
+            *p = ' ';
+    }
+}
+
+// Returns the number of big number operations one execution of a statement performs: the arithmetic operation of an
+// assignment, a conversion to decimal for every value written, and a decimal parse for every constant used or number read
+int statement_operations(int statement)
+{
+    const Token *t = &token_list[statement];
+    int end = statement_end(statement);
+
+    if (t->type == TOKEN_IDENTIFIER)
+        return 1 + (token_list[statement + 2].type == TOKEN_INTCONST);
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "repeat") == 0)
+        return token_list[statement + 1].type == TOKEN_INTCONST;
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "read") == 0)
+        return 1;
+    if (t->type == TOKEN_KEYWORD && strcmp(t->value, "write") == 0)
+    {
+        int operations = 0;
+        for (int i = statement + 1; i < end; i++)
+        {
+            if (token_list[i].type == TOKEN_IDENTIFIER)
+                operations++;
+            else if (token_list[i].type == TOKEN_INTCONST)
+                operations += 2;
+        }
+        return operations;
+    }
+    return 0;
+}
+
+// Times of a statement in the report
+typedef struct
+{
+    int token;
+    long long inclusive, exclusive;
+} ProfileLine;
+
+// Orders report lines by exclusive time, longest first
+int compare_exclusive(const void *a, const void *b)
+{
+    const ProfileLine *x = a, *y = b;
+    return (x->exclusive < y->exclusive) - (x->exclusive > y->exclusive);
+}
+
+// Function to write the path of a node from the root as frames separated by ';'
+void write_stack(FILE *file, int node)
+{
+    if (profile_nodes[node].parent > 0)
+    {
+        write_stack(file, profile_nodes[node].parent);
+        fputc(';', file);
+    }
+    char text[64];
+    describe_statement(profile_nodes[node].token, text, sizeof(text));
+    fprintf(file, "line %d: %s", token_list[profile_nodes[node].token].line, text);
+}
+
+// Function to print the report and write the collapsed stacks
+void profile_report()
+{
+    if (!profiling)
+        return;
+    profiling = 0;
+    output_flush(); // Keep the program output ahead of the report
+    fflush(stdout);
+
+    // A statement's inclusive time is its own time plus that of everything that ran in its loops, so every node
+    // adds its own time to itself and to each loop above it
+    ProfileLine *lines = calloc(token_count + 1, sizeof(ProfileLine));
+    long long total = 0;
+    for (int n = 1; n < profile_node_count; n++)
+    {
+        long long self = profile_nodes[n].self;
+        lines[profile_nodes[n].token].exclusive += self;
+        for (int a = n; a > 0; a = profile_nodes[a].parent)
+            lines[profile_nodes[a].token].inclusive += self;
+        total += self;
+    }
+
+    int count = 0;
+    for (int i = 0; i < token_count; i++)
+    {
+        if (statement_calls[i] > 0 || lines[i].exclusive > 0)
+        {
+            lines[count] = lines[i];
+            lines[count].token = i;
+            count++;
+        }
+    }
+    qsort(lines, count, sizeof(ProfileLine), compare_exclusive);
+
+    fprintf(stderr, "\n--- Profile: %.3f ms in %d statements ---\n", total / 1e6, count);
+    fprintf(stderr, "%6s %12s %12s %12s %7s %14s  %s\n", "line", "calls", "incl ms", "excl ms", "excl %", "bigint ops", "statement");
+    for (int i = 0; i < count && i < PROFILE_REPORT_LINES; i++)
+    {
+        char text[64];
+        int token = lines[i].token;
+        describe_statement(token, text, sizeof(text));
+        fprintf(stderr, "%6d %12lld %12.3f %12.3f %6.1f%% %14lld  %s\n", token_list[token].line, statement_calls[token],
+                lines[i].inclusive / 1e6, lines[i].exclusive / 1e6, total ? 100.0 * lines[i].exclusive / total : 0.0,
+                statement_calls[token] * statement_operations(token), text);
+    }
+    if (count > PROFILE_REPORT_LINES)
+        fprintf(stderr, "(%d more statements)\n", count - PROFILE_REPORT_LINES);
+    free(lines);
+
+    // Collapsed stacks: one line per path with its own time in microseconds
+    char folded[600];
+    snprintf(folded, sizeof(folded), "%s.folded", profile_name);
+    FILE *file = fopen(folded, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR]: Could not create '%s'.\n", folded);
+        return;
+    }
+    for (int n = 1; n < profile_node_count; n++)
+    {
+        long long micros = profile_nodes[n].self / 1000;
+        if (micros == 0)
+            continue;
+        write_stack(file, n);
+        fprintf(file, " %lld\n", micros);
+    }
+    fclose(file);
+    fprintf(stderr, "Collapsed stacks written to %s.\n", folded);
+}
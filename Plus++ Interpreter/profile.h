@@ -0,0 +1,31 @@
+// profile.h
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+
+// Number of statements listed in the hot-spot report
+#define PROFILE_REPORT_LINES 30
+
+// 1 while statements are being timed (--profile)
+extern int profiling;
+
+// Starts profiling the program <name>.ppp. The report is printed when the process exits, also after an error.
+void enable_profiling(const char *name);
+
+// Starts timing the statement starting at the given token. The first frames entries of the frame stack are the
+// loops it runs in; execution is 1 if the statement is executed (0 for the end of a loop iteration, whose time
+// belongs to the loop but is not another execution of it).
+void profile_start(int statement, int frames, int execution);
+
+// Stops timing the statement started last and adds the time to it
+void profile_stop();
+
+// Describes the statement starting at the given token in at most size - 1 characters, without ';'
+void describe_statement(int statement, char *text, size_t size);
+
+// Prints the statements that took the most time to stderr and writes the collapsed stacks of nested loops to
+// <name>.folded, for flame graph tools
+void profile_report();
+
+#endif
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "regions.h"
+#include "lexer.h"
+#include "error.h"
+#include "output.h"
+#include "interpreter.h"
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+// How a region uses a variable
+#define VAR_READ 1
+#define VAR_WRITTEN 2
+
+// A top-level statement with the variables it reads and writes (indexed by var_table slot)
+typedef struct
+{
+    int start, end;
+    int parallel; // 0 if it must run on its own: it declares variables, reads input, uses undeclared ones, or has no loop
+    unsigned char access[MAX_VARS];
+} Region;
+
+// Function to get the index just past a top-level statement. A repeat statement ends with its body, which
+// statement_end() alone would cut short at the first ';' inside a block.
+int region_end(int start)
+{
+    while (token_list[start].type == TOKEN_KEYWORD && strcmp(token_list[start].value, "repeat") == 0)
+        start += 3; // repeat <count> times
+    return statement_end(start);
+}
+
+// Function to find the variables a top-level statement reads and writes. Assignment targets and repeat counts
+// (which count down) are written; every variable mentioned is treated as read.
+void analyze_region(Region *r, int start)
+{
+    r->start = start;
+    r->end = region_end(start);
+    r->parallel = 0;
+    memset(r->access, 0, sizeof(r->access));
+
+    int loops = 0;
+    for (int i = start; i < r->end; i++)
+    {
+        Token *t = &token_list[i];
+        if (t->type == TOKEN_KEYWORD && strcmp(t->value, "number") == 0)
+            return; // Declarations change var_table, which the other processes share
+        if (t->type == TOKEN_KEYWORD && strcmp(t->value, "read") == 0)
+            return; // Numbers have to be taken from the input in program order
+        if (t->type == TOKEN_KEYWORD && strcmp(t->value, "repeat") == 0)
+            loops++;
+        if (t->type != TOKEN_IDENTIFIER)
+            continue;
+
+        int idx = find_var(t->value);
+        if (idx < 0)
+            return; // Leave the error to the serial run
+        r->access[idx] |= VAR_READ;
+
+        int target = i + 1 < r->end && token_list[i + 1].type == TOKEN_OPERATOR;
+        int count = i > start && token_list[i - 1].type == TOKEN_KEYWORD && strcmp(token_list[i - 1].value, "repeat") == 0;
+        if (target || count)
+            r->access[idx] |= VAR_WRITTEN;
+    }
+    r->parallel = loops > 0;
+}
+
+// Function to check that neither region writes a variable the other one uses
+int regions_independent(const Region *a, const Region *b)
+{
+    for (int v = 0; v < var_count; v++)
+    {
+        if (((a->access[v] & VAR_WRITTEN) && b->access[v]) || ((b->access[v] & VAR_WRITTEN) && a->access[v]))
+            return 0;
+    }
+    return 1;
+}
+
+// Function to run one region in the current process
+void run_region(const Region *r)
+{
+    current = r->start;
+    frame_depth = 0;
+    run_until(r->end);
+}
+
+#ifndef _WIN32
+// Files a region's process hands back: its output, its error messages and the variables it wrote
+typedef struct
+{
+    pid_t pid; // -1 if the process could not be started and the region runs in the parent instead
+    FILE *out;
+    FILE *err;
+    FILE *vars;
+} RegionProcess;
+
+// Function to run a region in a child process and exit. Errors end the process with status 1.
+_Noreturn void run_region_child(const Region *r, RegionProcess *p)
+{
+    output_set_capture(NULL); // The result cache belongs to the parent
+    output_set_stream(p->out);
+    fflush(stderr);
+    dup2(fileno(p->err), 2);
+
+    jmp_buf recovery;
+    error_recovery = &recovery;
+    if (setjmp(recovery) != 0)
+    {
+        output_flush();
+        fflush(p->out);
+        fflush(stderr);
+        _exit(1);
+    }
+    run_region(r);
+    output_flush();
+    fflush(p->out);
+
+    // Hand back the written variables: slot, sign, length and limbs
+    for (int v = 0; v < var_count; v++)
+    {
+        if (!(r->access[v] & VAR_WRITTEN))
+            continue;
+        const BigInt *value = variable_value(v);
+        int header[3] = {v, value->negative, value->length};
+        fwrite(header, sizeof(header), 1, p->vars);
+        fwrite(value->limbs, sizeof(uint32_t), value->length, p->vars);
+    }
+    fflush(p->vars);
+    fflush(stderr);
+    _exit(0);
+}
+
+// Function to copy the contents of a temporary file to the program output, or to stderr
+void replay_file(FILE *file, int to_stderr)
+{
+    char buf[4096];
+    size_t n;
+    rewind(file);
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    {
+        if (to_stderr)
+            fwrite(buf, 1, n, stderr);
+        else
+            output_write(buf, n);
+    }
+}
+
+// Function to install the variables a region's process wrote
+void read_region_variables(FILE *file)
+{
+    int header[3];
+    rewind(file);
+    while (fread(header, sizeof(header), 1, file) == 1)
+    {
+        BigInt *value = variable_value(header[0]);
+        bigint_reserve(value, header[2]);
+        if (fread(value->limbs, sizeof(uint32_t), header[2], file) != (size_t)header[2])
+            break;
+        value->negative = header[1];
+        value->length = header[2];
+    }
+}
+
+// Function to stop the processes of a group that are still running
+void stop_region_processes(RegionProcess *processes, int from, int count)
+{
+    for (int k = from; k < count; k++)
+    {
+        if (processes[k].pid > 0)
+        {
+            kill(processes[k].pid, SIGKILL);
+            waitpid(processes[k].pid, NULL, 0);
+        }
+    }
+}
+
+// Function to run a group of independent regions in parallel and merge their results in program order
+void run_region_group(const Region *group, int count)
+{
+    RegionProcess processes[MAX_REGION_GROUP];
+
+    output_flush();
+    fflush(stdout);
+    fflush(stderr);
+
+    for (int k = 0; k < count; k++)
+    {
+        RegionProcess *p = &processes[k];
+        p->out = tmpfile();
+        p->err = tmpfile();
+        p->vars = tmpfile();
+        p->pid = (p->out && p->err && p->vars) ? fork() : -1;
+        if (p->pid == 0)
+            run_region_child(&group[k], p);
+    }
+
+    for (int k = 0; k < count; k++)
+    {
+        RegionProcess *p = &processes[k];
+        int status = 0;
+        if (p->pid < 0)
+        {
+            // No process for this region: run it here at its turn, which keeps the output in order
+            run_region(&group[k]);
+        }
+        else
+        {
+            waitpid(p->pid, &status, 0);
+            p->pid = 0;
+            replay_file(p->out, 0);
+            replay_file(p->err, 1);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                // Regions after the failing one would not have run at all
+                stop_region_processes(processes, k + 1, count);
+                if (!WIFEXITED(status))
+                    fprintf(stderr, "[ERROR] (line %d): Parallel region stopped by signal %d.\n", token_list[group[k].start].line, WTERMSIG(status));
+                for (int j = k; j < count; j++)
+                {
+                    if (processes[j].out) fclose(processes[j].out);
+                    if (processes[j].err) fclose(processes[j].err);
+                    if (processes[j].vars) fclose(processes[j].vars);
+                }
+                error_exit();
+            }
+            read_region_variables(p->vars);
+        }
+        if (p->out) fclose(p->out);
+        if (p->err) fclose(p->err);
+        if (p->vars) fclose(p->vars);
+        p->out = p->err = p->vars = NULL;
+    }
+
+    // The children ran from the start of each region, so the parent continues after the last one
+    current = group[count - 1].end;
+    frame_depth = 0;
+}
+#endif
+
+// Statements of the group being formed
+Region region_group[MAX_REGION_GROUP];
+
+// Function to run the program, grouping independent top-level statements
+void run_regions()
+{
+    find_block_ends();
+    forget_compiled_bodies();
+
+#ifdef _WIN32
+    run_until(token_count); // No fork(): everything runs in order
+#else
+    Region *group = region_group;
+    current = 0;
+    frame_depth = 0;
+    while (current < token_count)
+    {
+        analyze_region(&group[0], current);
+        int count = 1;
+
+        // Extend the group with following statements that are independent of every member
+        while (group[0].parallel && count < MAX_REGION_GROUP && group[count - 1].end < token_count)
+        {
+            Region *next = &group[count];
+            analyze_region(next, group[count - 1].end);
+            int independent = next->parallel;
+            for (int k = 0; independent && k < count; k++)
+                independent = regions_independent(&group[k], next);
+            if (!independent)
+                break;
+            count++;
+        }
+
+        if (count > 1)
+            run_region_group(group, count);
+        else
+            run_region(&group[0]);
+    }
+#endif
+}
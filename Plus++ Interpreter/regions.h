@@ -0,0 +1,13 @@
+// regions.h
+#ifndef REGIONS_H
+#define REGIONS_H
+
+// Largest number of top-level statements run side by side
+#define MAX_REGION_GROUP 64
+
+// Runs the program from the start. Consecutive top-level statements containing loops that touch disjoint variables
+// are run at the same time in separate processes; their output is merged in program order, so it is identical to
+// running them one after another.
+void run_regions();
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "repl.h"
+#include "lexer.h"
+#include "parser.h"
+#include "interpreter.h"
+#include "output.h"
+#include "file_utils.h"
+#include "error.h"
+
+// Maximum size of one REPL input (a statement, possibly spanning several lines)
+#define MAX_INPUT 16384
+
+// Function to check whether the input is a complete statement: all blocks, strings and comments
+// are closed and it ends with ';' or '}'. Otherwise the REPL keeps reading lines.
+int is_complete_input(const char *text)
+{
+    int depth = 0;
+    int in_string = 0, in_comment = 0;
+    char last = 0;
+
+    for (const char *p = text; *p; p++)
+    {
+        if (in_string)
+        {
+            if (*p == '"')
+                in_string = 0;
+        }
+        else if (in_comment)
+        {
+            if (*p == '*')
+                in_comment = 0;
+        }
+        else if (*p == '"')
+            in_string = 1;
+        else if (*p == '*' && p[1] == '=' && (isalnum((unsigned char)last) || last == '_'))
+            p++; // "x *= 2": the multiply operator, not a comment (the lexer decides exactly)
+        else if (*p == '*')
+            in_comment = 1;
+        else if (*p == '{')
+            depth++;
+        else if (*p == '}')
+            depth--;
+
+        // Remember the last character that is not whitespace or inside a comment
+        if (!in_comment && *p != '*' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            last = *p;
+    }
+    return !in_string && !in_comment && depth <= 0 && (last == ';' || last == '}');
+}
+
+// Function to tokenize, check and execute one input. The variables and declared identifiers
+// from earlier inputs are kept; on an error, the declarations of this input are undone.
+void execute_input(const char *text)
+{
+    int saved_declared = declared_count;
+    int saved_vars = var_count;
+    FILE *in = open_string_stream(text);
+    jmp_buf recovery;
+
+    if (!in)
+    {
+        fprintf(stderr, "[ERROR]: Could not read input.\n");
+        return;
+    }
+
+    if (setjmp(recovery) != 0)
+    {
+        // An error was reported: forget this input and keep the session going
+        error_recovery = NULL;
+        fclose(in);
+        forget_identifiers(saved_declared);
+        var_count = saved_vars;
+        output_flush();
+        fflush(stdout);
+        return;
+    }
+    error_recovery = &recovery;
+
+    // Earlier inputs have already run and are never jumped back to, so only this input's tokens are kept
+    token_count = 0;
+    tokenize(in, NULL);
+
+    // Check the syntax of the new statements
+    current = 0;
+    while (current < token_count)
+    {
+        parse_statement();
+    }
+
+    // Run them with the variables of the session
+    current = 0;
+    frame_depth = 0;
+    run_program();
+
+    error_recovery = NULL;
+    fclose(in);
+    output_flush();
+    fflush(stdout);
+}
+
+// Function to run the REPL: read statements from stdin and execute each one as soon as it is complete
+void run_repl()
+{
+    char input[MAX_INPUT];
+    char line[1024];
+    size_t length = 0;
+
+    printf("Plus++ interactive mode. Enter statements, end with Ctrl-D (Ctrl-Z on Windows).\n");
+
+    while (1)
+    {
+        printf(length == 0 ? "ppp> " : "...> ");
+        fflush(stdout);
+
+        if (fgets(line, sizeof(line), stdin) == NULL)
+            break; // End of input
+
+        size_t line_length = strlen(line);
+        if (length + line_length >= sizeof(input))
+        {
+            fprintf(stderr, "[ERROR]: Input is too long.\n");
+            length = 0;
+            continue;
+        }
+        memcpy(input + length, line, line_length + 1);
+        length += line_length;
+
+        // Blank lines are ignored; incomplete statements continue on the next line
+        if (strspn(input, " \t\r\n") == length)
+        {
+            length = 0;
+            continue;
+        }
+        if (!is_complete_input(input))
+            continue;
+
+        // The final line break is not part of the statement
+        input[strcspn(input + length - line_length, "\r\n") + length - line_length] = '\0';
+        execute_input(input);
+        length = 0;
+    }
+    printf("\n");
+}
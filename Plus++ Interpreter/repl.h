@@ -0,0 +1,8 @@
+// repl.h
+#ifndef REPL_H
+#define REPL_H
+
+// Runs the interactive read-eval-print loop until the end of input
+void run_repl();
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "status.h"
+#include "lexer.h"
+#include "interpreter.h"
+#include "output.h"
+#include "metrics.h"
+#include "profile.h"
+#include "bench.h"
+#include "memory.h"
+#include "input.h"
+
+volatile sig_atomic_t status_requested = 0;
+
+// Time the handler was installed, and time and statement count of the previous report
+double status_epoch = 0;
+double status_last_time = 0;
+long long status_last_statements = 0;
+
+// Signal handler: only sets the flag, the report is printed by the interpreter at the next check
+void request_status(int signal_number)
+{
+    (void)signal_number;
+    status_requested = 1;
+}
+
+// Function to install the SIGUSR1 handler
+void enable_status_signal()
+{
+    status_epoch = bench_seconds();
+    status_last_time = status_epoch;
+#ifdef SIGUSR1
+    struct sigaction action;
+    action.sa_handler = request_status;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART; // Output written while the signal arrives is not interrupted
+    sigaction(SIGUSR1, &action, NULL);
+#endif
+}
+
+// Function to print the status of the run
+void report_status(const CompiledBody *body, int pc, int depth, long long statements)
+{
+    status_requested = 0;
+
+    double now = bench_seconds();
+    long long executed = statements_executed + statements;
+    char text[64];
+
+    fprintf(stderr, "\n--- Status after %.1f s ---\n", now - status_epoch);
+    if (body)
+        fprintf(stderr, "Line %d (compiled loop body)\n", body->code[pc].line);
+    else if (current < token_count)
+    {
+        describe_statement(current, text, sizeof(text));
+        fprintf(stderr, "Line %d: %s\n", token_list[current].line, text);
+    }
+
+    // Loops of the interpreter, outermost first, then the loops inside the running compiled body
+    for (int i = 0; i < frame_depth; i++)
+    {
+        const Frame *f = &frame_stack[i];
+        if (f->count_token < 0)
+            continue;
+        describe_statement(f->count_token - 1, text, sizeof(text)); // The repeat keyword precedes the count
+        fprintf(stderr, "  line %d: %s, %lld iterations left\n", token_list[f->count_token].line, text, f->remaining);
+    }
+    for (int i = 0, active = 0; body && i <= pc && active < depth; i++)
+    {
+        // A loop is active if the instruction being run lies inside its body
+        if (body->code[i].op == OP_REPEAT && body->code[i].jump >= pc)
+        {
+            fprintf(stderr, "  line %d: repeat (compiled), %lld iterations left\n", body->code[i].line, body->loops[active]);
+            active++;
+        }
+    }
+
+    double since_last = now - status_last_time;
+    fprintf(stderr, "Statements: %lld (%.0f/s overall, %.0f/s since the last status)\n", executed,
+            now > status_epoch ? executed / (now - status_epoch) : 0.0,
+            since_last > 0 ? (executed - status_last_statements) / since_last : 0.0);
+    fprintf(stderr, "Output: %lld bytes in %lld flushes\n", output_bytes, output_flushes);
+    if (input_numbers > 0)
+        fprintf(stderr, "Input: %lld numbers in %lld bytes\n", input_numbers, input_bytes);
+    fprintf(stderr, "Memory: %.1f MB (peak %.1f MB)\n", memory_used / 1048576.0, memory_peak / 1048576.0);
+    fflush(stderr);
+
+    status_last_time = now;
+    status_last_statements = executed;
+}
@@ -0,0 +1,21 @@
+// status.h
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <signal.h>
+#include "compiler.h"
+
+// Set by the SIGUSR1 handler; the interpreter checks it between statements and in compiled loops, which is all a
+// status request costs until one arrives
+extern volatile sig_atomic_t status_requested;
+
+// Installs the SIGUSR1 handler (where the platform has the signal). Running programs keep running when one arrives.
+void enable_status_signal();
+
+// Prints the status of the run to stderr: the current line, the active loops with the iterations they have left,
+// statements per second and output volume. In compiled code, body is the running body, pc its instruction, depth
+// the number of its loops that are active and statements the statements it has executed but not yet counted;
+// body is NULL in the interpreter.
+void report_status(const CompiledBody *body, int pc, int depth, long long statements);
+
+#endif
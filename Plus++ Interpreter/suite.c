@@ -0,0 +1,457 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "suite.h"
+#include "bench.h"
+#include "lexer.h"
+#include "parser.h"
+#include "interpreter.h"
+#include "output.h"
+#include "file_utils.h"
+#include "cache.h"
+#include "metrics.h"
+
+// Each phase of a script is timed in this many rounds of at least SUITE_ROUND_SECONDS. A round times every phase of
+// every script, so the rounds of one phase are spread over the whole run and their spread shows how much the rest of
+// the machine disturbed it.
+#define SUITE_ROUNDS 9
+#define SUITE_ROUND_SECONDS 0.15
+
+// A metric has only regressed if it is worse than the baseline by more than this many times the spread of the two
+// measurements added up; a smaller difference is noise of the machine, whatever the threshold
+#define SUITE_NOISE_FACTOR 3
+
+// Peak memory varies by a few hundred kB between runs of the same binary (allocator arenas, the stack and the page
+// accounting of the kernel), so a smaller increase is noise as well
+#define SUITE_MEMORY_NOISE_KB 1024
+
+// Largest number of scripts compared with a baseline
+#define MAX_SUITE_SCRIPTS 16
+
+// Source text of a generated script
+typedef struct
+{
+    char *text;
+    size_t length;
+    size_t capacity;
+} Source;
+
+// Generates a script into the source and returns the number of statements it executes
+typedef long long (*ScriptGenerator)(Source *s);
+
+// A script of the corpus
+typedef struct
+{
+    const char *name;
+    ScriptGenerator generate;
+} SuiteScript;
+
+// Measurements of one script
+typedef struct
+{
+    const char *name;
+    size_t source_bytes;
+    int tokens;
+    long long steps;
+    double lex_mb_per_s;
+    double parse_tokens_per_s;
+    double exec_steps_per_s;
+    double lex_spread; // Spread between the rounds of each phase, relative to the median round
+    double parse_spread;
+    double exec_spread;
+    long long peak_rss_kb;
+    double lex_times[SUITE_ROUNDS]; // Time of one run of each phase in every round
+    double parse_times[SUITE_ROUNDS];
+    double exec_times[SUITE_ROUNDS];
+} SuiteResult;
+
+// Function to append formatted text to a source
+void source_printf(Source *s, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    if (s->length + n + 1 > s->capacity)
+    {
+        s->capacity = (s->length + n + 1) * 2;
+        s->text = realloc(s->text, s->capacity);
+    }
+    va_start(args, format);
+    vsnprintf(s->text + s->length, n + 1, format, args);
+    va_end(args);
+    s->length += n;
+}
+
+// Function to generate a deterministic constant of the given number of digits
+void source_literal(Source *s, int digits, unsigned *state)
+{
+    for (int i = 0; i < digits; i++)
+    {
+        *state = *state * 1103515245u + 12345u;
+        source_printf(s, "%c", (i == 0 ? '1' : '0') + (int)((*state >> 16) % (i == 0 ? 9 : 10)));
+    }
+}
+
+// Seven loops of eight iterations nested into each other around a single counter
+long long generate_nested_loops(Source *s)
+{
+    int depth = 7, count = 8;
+    long long steps = 1;
+
+    source_printf(s, "* Deeply nested loops around one counter *\nnumber i;\ni := 0;\n");
+    for (int d = 0; d < depth; d++)
+    {
+        source_printf(s, "%*srepeat %d times {\n", d * 4, "", count);
+        steps *= count;
+    }
+    source_printf(s, "%*si += 1;\n", depth * 4, "");
+    for (int d = depth - 1; d >= 0; d--)
+        source_printf(s, "%*s}\n", d * 4, "");
+    source_printf(s, "write i and newline;\n");
+    return steps + 2;
+}
+
+// Eighty variables, each updated from the one before it in a loop
+long long generate_many_variables(Source *s)
+{
+    int vars = 80, count = 2000;
+
+    source_printf(s, "* Many variables updated in one loop *\n");
+    for (int v = 0; v < vars; v++)
+        source_printf(s, "number v%d;\n", v);
+    source_printf(s, "repeat %d times {\n    v0 += 1;\n", count);
+    for (int v = 1; v < vars; v++)
+        source_printf(s, "    v%d += v%d;\n", v, v - 1);
+    source_printf(s, "}\nwrite v%d and newline;\n", vars - 1);
+    return (long long)vars * count + 1;
+}
+
+// Constants of up to 100 digits, at the top level and multiplied and summed in a loop
+long long generate_huge_literals(Source *s)
+{
+    int top = 60, groups = 6, count = 2000;
+    unsigned state = 12345;
+
+    source_printf(s, "* Huge integer constants *\nnumber a;\nnumber b;\nnumber c;\n");
+    for (int i = 0; i < top; i++)
+    {
+        source_printf(s, "a := ");
+        source_literal(s, 100 - i % 20, &state);
+        source_printf(s, ";\n");
+    }
+    source_printf(s, "repeat %d times {\n", count);
+    for (int g = 0; g < groups; g++)
+    {
+        source_printf(s, "    a := ");
+        source_literal(s, 100 - g, &state);
+        source_printf(s, ";\n    b := ");
+        source_literal(s, 90 - g, &state);
+        source_printf(s, ";\n    a *= b;\n    c %s a;\n", g % 2 ? "-=" : "+=");
+    }
+    source_printf(s, "}\nwrite c and newline;\n");
+    return top + (long long)count * groups * 4 + 1;
+}
+
+// A loop writing strings and numbers on every iteration
+long long generate_write_heavy(Source *s)
+{
+    int count = 100000;
+
+    source_printf(s, "* Write-heavy output *\nnumber i;\n");
+    source_printf(s, "repeat %d times {\n    write \"Line of output with some text:\" and i and \" \" and i and newline;\n    i += 1;\n}\n", count);
+    return 2LL * count;
+}
+
+// A hundred loops, each preceded by a long comment
+long long generate_comment_heavy(Source *s)
+{
+    int blocks = 100, lines = 100, count = 100;
+
+    source_printf(s, "number c;\n");
+    for (int b = 0; b < blocks; b++)
+    {
+        source_printf(s, "* Block %d.\n", b);
+        for (int l = 0; l < lines; l++)
+            source_printf(s, "  Comment line %d of block %d: commentary that the lexer has to skip over quickly.\n", l, b);
+        source_printf(s, "*\nrepeat %d times { c += 1; }\n", count);
+    }
+    source_printf(s, "write c and newline;\n");
+    return (long long)blocks * count + 1;
+}
+
+// The benchmark corpus
+SuiteScript suite_scripts[] = {
+    {"nested_loops", generate_nested_loops},
+    {"many_variables", generate_many_variables},
+    {"huge_literals", generate_huge_literals},
+    {"write_heavy", generate_write_heavy},
+    {"comment_heavy", generate_comment_heavy},
+    {NULL, NULL}};
+
+// Function to forget the tokens and declared identifiers of the previous run of the lexer
+void reset_lexer()
+{
+    token_count = 0;
+    forget_identifiers(0);
+}
+
+// Function to tokenize a source once
+void suite_lex(const Source *s)
+{
+    reset_lexer();
+    FILE *in = open_string_stream(s->text);
+    if (!in)
+    {
+        fprintf(stderr, "[ERROR]: Could not read generated script.\n");
+        exit(1);
+    }
+    tokenize(in, NULL);
+    fclose(in);
+}
+
+// Function to check the syntax of the token list once
+void suite_parse(const Source *s)
+{
+    (void)s; // Parses the tokens of the last lexing run
+    current = 0;
+    while (current < token_count)
+        parse_statement();
+}
+
+// Function to run the parsed program once
+void suite_execute(const Source *s)
+{
+    (void)s;
+    interpret();
+    output_flush();
+}
+
+// Function to time one round of a phase: runs it repeatedly for at least SUITE_ROUND_SECONDS and returns the time
+// of one run
+double time_round(void (*phase)(const Source *s), const Source *s)
+{
+    int runs = 0;
+    double start = bench_seconds(), elapsed;
+    do
+    {
+        phase(s);
+        runs++;
+        elapsed = bench_seconds() - start;
+    } while (elapsed < SUITE_ROUND_SECONDS);
+    return elapsed / runs;
+}
+
+// Function to time one round of each phase of a script. The phases run in order, so the tokens of the last lexing
+// run are the ones parsed and executed.
+void measure_round(const Source *s, FILE *sink, SuiteResult *r, int round)
+{
+    r->lex_times[round] = time_round(suite_lex, s);
+    r->tokens = token_count;
+    r->parse_times[round] = time_round(suite_parse, s);
+
+    // The program output goes to the sink, so writing it to a terminal is not part of the measurement
+    output_set_stream(sink);
+    r->exec_times[round] = time_round(suite_execute, s);
+    output_set_stream(NULL);
+}
+
+// Function to find the time of a phase from its rounds: returns the median round, which ignores the rounds disturbed
+// by the rest of the machine, and sets the spread to the median absolute deviation of the rounds relative to it, as
+// in the micro-benchmarks
+double median_round(const double *rounds, double *spread)
+{
+    double times[SUITE_ROUNDS], deviations[SUITE_ROUNDS];
+    memcpy(times, rounds, sizeof(times));
+    double time = median(times, SUITE_ROUNDS);
+    for (int round = 0; round < SUITE_ROUNDS; round++)
+        deviations[round] = rounds[round] > time ? rounds[round] - time : time - rounds[round];
+    *spread = median(deviations, SUITE_ROUNDS) / time;
+    return time;
+}
+
+// Function to turn the rounds of a script into its measurements
+void summarize_script(const Source *s, SuiteResult *r)
+{
+    r->source_bytes = s->length;
+    r->lex_mb_per_s = s->length / median_round(r->lex_times, &r->lex_spread) / 1e6;
+    r->parse_tokens_per_s = r->tokens / median_round(r->parse_times, &r->parse_spread);
+    r->exec_steps_per_s = r->steps / median_round(r->exec_times, &r->exec_spread);
+    r->peak_rss_kb = peak_rss_kb();
+}
+
+// Function to save a generated script as <dir>/<name>.ppp
+void save_corpus_script(const char *dir, const char *name, const Source *s)
+{
+    char path[600];
+    snprintf(path, sizeof(path), "%s/%s.ppp", dir, name);
+    FILE *file = fopen(path, "w");
+    if (!file || fwrite(s->text, 1, s->length, file) != s->length)
+    {
+        fprintf(stderr, "[ERROR]: Could not write '%s'.\n", path);
+        exit(1);
+    }
+    fclose(file);
+}
+
+// Function to write the results as JSON
+void write_suite_json(FILE *file, const SuiteResult *results, int count)
+{
+    fprintf(file, "{\n  \"version\": %d,\n  \"scripts\": [\n", PPP_VERSION);
+    for (int i = 0; i < count; i++)
+    {
+        const SuiteResult *r = &results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"source_bytes\": %zu, \"tokens\": %d, \"steps\": %lld, ", r->name, r->source_bytes, r->tokens, r->steps);
+        fprintf(file, "\"lex_mb_per_s\": %.3f, \"parse_tokens_per_s\": %.0f, \"exec_steps_per_s\": %.0f, ",
+                r->lex_mb_per_s, r->parse_tokens_per_s, r->exec_steps_per_s);
+        fprintf(file, "\"lex_spread\": %.4f, \"parse_spread\": %.4f, \"exec_spread\": %.4f, \"peak_rss_kb\": %lld}%s\n",
+                r->lex_spread, r->parse_spread, r->exec_spread, r->peak_rss_kb, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+// Function to find a number in the baseline entry of a script. The baseline is a file written by write_suite_json,
+// so the fields of an entry follow its name on the same line. Returns 0 if the script or the field is missing.
+int baseline_metric(const char *json, const char *name, const char *field, double *value)
+{
+    char key[128];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char *entry = strstr(json, key);
+    if (!entry)
+        return 0;
+
+    const char *line_end = strchr(entry, '\n');
+    snprintf(key, sizeof(key), "\"%s\":", field);
+    const char *p = strstr(entry, key);
+    if (!p || (line_end && p > line_end))
+        return 0;
+
+    *value = strtod(p + strlen(key), NULL);
+    return 1;
+}
+
+// Function to compare one metric with the baseline and print it. A timed metric has a spread field (NULL for peak
+// memory) and only regresses if the loss is also beyond the noise of the two measurements; peak memory only regresses
+// if it grew by more than SUITE_MEMORY_NOISE_KB. Returns 1 if it regressed.
+int compare_metric(const char *json, const char *name, const char *field, const char *spread_field, const char *label,
+                   double current, double current_spread, int higher_is_better, int threshold)
+{
+    double baseline;
+    if (!baseline_metric(json, name, field, &baseline) || baseline <= 0)
+    {
+        printf("%-16s %-20s %14s %14.*f %9s %8s\n", name, label, "-", current < 1000 ? 1 : 0, current, "new", "");
+        return 0;
+    }
+
+    // A baseline written before spreads were recorded counts as exact
+    double baseline_spread = 0, noise = SUITE_MEMORY_NOISE_KB / baseline * 100;
+    if (spread_field)
+    {
+        baseline_metric(json, name, spread_field, &baseline_spread);
+        noise = SUITE_NOISE_FACTOR * (baseline_spread + current_spread) * 100;
+    }
+
+    double change = (current - baseline) / baseline * 100;
+    double loss = higher_is_better ? -change : change;
+    int regressed = loss > threshold && loss > noise;
+    int decimals = baseline < 1000 ? 1 : 0;
+    printf("%-16s %-20s %14.*f %14.*f %+8.1f%% %7.1f%%%s\n", name, label, decimals, baseline, decimals, current, change,
+           noise, regressed ? "  REGRESSION" : "");
+    return regressed;
+}
+
+// Function to compare all results with a baseline file. Returns the number of regressions.
+int compare_with_baseline(const char *baseline_file, const SuiteResult *results, int count, int threshold)
+{
+    char *json = read_text_file(baseline_file);
+    if (!json)
+    {
+        fprintf(stderr, "[ERROR]: Could not read baseline '%s'.\n", baseline_file);
+        exit(1);
+    }
+
+    printf("\nComparison with %s (regression threshold %d%%):\n", baseline_file, threshold);
+    printf("%-16s %-20s %14s %14s %9s %8s\n", "script", "metric", "baseline", "current", "change", "noise");
+
+    int regressions = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const SuiteResult *r = &results[i];
+        regressions += compare_metric(json, r->name, "lex_mb_per_s", "lex_spread", "lexing MB/s", r->lex_mb_per_s,
+                                      r->lex_spread, 1, threshold);
+        regressions += compare_metric(json, r->name, "parse_tokens_per_s", "parse_spread", "parsing tokens/s",
+                                      r->parse_tokens_per_s, r->parse_spread, 1, threshold);
+        regressions += compare_metric(json, r->name, "exec_steps_per_s", "exec_spread", "execution steps/s",
+                                      r->exec_steps_per_s, r->exec_spread, 1, threshold);
+        regressions += compare_metric(json, r->name, "peak_rss_kb", NULL, "peak memory kB", (double)r->peak_rss_kb, 0,
+                                      0, threshold);
+    }
+    free(json);
+
+    if (regressions)
+        printf("%d regression%s.\n", regressions, regressions == 1 ? "" : "s");
+    else
+        printf("No regressions.\n");
+    return regressions;
+}
+
+// Function to run the benchmark suite
+int run_benchmark_suite(const char *json_file, const char *baseline_file, int threshold, const char *corpus_dir)
+{
+    SuiteResult results[MAX_SUITE_SCRIPTS];
+    Source sources[MAX_SUITE_SCRIPTS];
+    int count = 0;
+
+#ifdef _WIN32
+    FILE *sink = fopen("NUL", "wb");
+#else
+    FILE *sink = fopen("/dev/null", "wb");
+#endif
+    if (!sink)
+    {
+        fprintf(stderr, "[ERROR]: Could not open the null device.\n");
+        exit(1);
+    }
+
+    for (; count < MAX_SUITE_SCRIPTS && suite_scripts[count].name; count++)
+    {
+        Source *s = &sources[count];
+        *s = (Source){NULL, 0, 0};
+        results[count].name = suite_scripts[count].name;
+        results[count].steps = suite_scripts[count].generate(s);
+
+        if (corpus_dir)
+            save_corpus_script(corpus_dir, suite_scripts[count].name, s);
+    }
+
+    for (int round = 0; round < SUITE_ROUNDS; round++)
+    {
+        for (int i = 0; i < count; i++)
+            measure_round(&sources[i], sink, &results[i], round);
+    }
+    fclose(sink);
+
+    printf("%-16s %10s %8s %12s %12s %14s %14s %12s\n", "script", "bytes", "tokens", "steps", "lex MB/s", "parse tok/s", "exec steps/s", "peak kB");
+    for (int i = 0; i < count; i++)
+    {
+        SuiteResult *r = &results[i];
+        summarize_script(&sources[i], r);
+        printf("%-16s %10zu %8d %12lld %12.1f %14.0f %14.0f %12lld\n", r->name, r->source_bytes, r->tokens, r->steps,
+               r->lex_mb_per_s, r->parse_tokens_per_s, r->exec_steps_per_s, r->peak_rss_kb);
+        free(sources[i].text);
+    }
+
+    FILE *file = fopen(json_file, "w");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR]: Could not create '%s'.\n", json_file);
+        exit(1);
+    }
+    write_suite_json(file, results, count);
+    fclose(file);
+    printf("Results written to %s.\n", json_file);
+
+    return baseline_file ? compare_with_baseline(baseline_file, results, count, threshold) : 0;
+}
@@ -0,0 +1,15 @@
+// suite.h
+#ifndef SUITE_H
+#define SUITE_H
+
+// Regression threshold used when none is given, in percent
+#define DEFAULT_BENCH_THRESHOLD 10
+
+// Runs the end-to-end benchmark on a generated corpus of scripts (deeply nested loops, many variables, huge literals,
+// write-heavy and comment-heavy sources). Prints lexing MB/s, parsing tokens/s, execution steps/s and peak memory for
+// each script and writes them to json_file. If corpus_dir is set, the generated scripts are also saved there.
+// If baseline_file is set, the results are compared with it and every metric that is more than threshold percent
+// worse counts as a regression. Returns the number of regressions.
+int run_benchmark_suite(const char *json_file, const char *baseline_file, int threshold, const char *corpus_dir);
+
+#endif
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "trace.h"
+#include "lexer.h"
+#include "profile.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Deepest nesting of spans that is recorded; deeper spans are counted but not recorded
+#define TRACE_MAX_DEPTH 32
+
+int trace_level = TRACE_OFF;
+int trace_categories = TRACE_ALL;
+int trace_spans = 0;
+
+// Chrome trace file, NULL if none, and whether an event has been written to it yet
+FILE *trace_file = NULL;
+int trace_file_events = 0;
+
+// Time tracing started, which is time 0 in the trace file
+long long trace_epoch = 0;
+
+// Open spans
+typedef struct
+{
+    char name[96];
+    int category;
+    int level;
+    int recorded; // 0 if the category is not traced
+    long long start;
+} TraceSpan;
+
+TraceSpan trace_stack[TRACE_MAX_DEPTH];
+int trace_depth = 0;
+
+// 1 while a span of a top-level statement is open
+int trace_statement_open = 0;
+
+// Names of the levels and categories, in order of their values and bits
+const char *trace_level_names[] = {"off", "info", "debug", "verbose", NULL};
+const char *trace_category_names[] = {"lex", "parse", "exec", "io", NULL};
+
+// Returns a monotonic time in nanoseconds
+long long trace_clock()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+// Function to parse a level name
+int trace_level_value(const char *name)
+{
+    for (int i = 0; trace_level_names[i]; i++)
+    {
+        if (strcmp(name, trace_level_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// Function to parse a list of category names such as "lex,exec"
+int trace_category_mask(const char *list)
+{
+    int mask = 0;
+    while (*list)
+    {
+        size_t length = strcspn(list, ",");
+        int found = 0;
+        if (length == 3 && strncmp(list, "all", 3) == 0)
+        {
+            mask |= TRACE_ALL;
+            found = 1;
+        }
+        for (int i = 0; trace_category_names[i] && !found; i++)
+        {
+            if (strlen(trace_category_names[i]) == length && strncmp(list, trace_category_names[i], length) == 0)
+            {
+                mask |= 1 << i;
+                found = 1;
+            }
+        }
+        if (!found)
+            return 0;
+        list += length;
+        if (*list == ',')
+            list++;
+    }
+    return mask;
+}
+
+// Returns the name of a category
+const char *trace_category_name(int category)
+{
+    for (int i = 0; trace_category_names[i]; i++)
+    {
+        if (category == 1 << i)
+            return trace_category_names[i];
+    }
+    return "trace";
+}
+
+// Function to write a string as a JSON string literal
+void write_json_string(FILE *file, const char *s)
+{
+    fputc('"', file);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(file, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(file, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+// Function to close the trace file, ending the spans still open (e.g. after a runtime error)
+void finish_tracing()
+{
+    while (trace_depth > 0)
+        trace_end();
+    if (trace_file)
+    {
+        fprintf(trace_file, "\n]}\n");
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+}
+
+// Function to set up tracing
+void start_tracing(int level, int categories, const char *file)
+{
+    trace_level = level;
+    trace_categories = categories;
+    trace_epoch = trace_clock();
+
+    if (file)
+    {
+        trace_file = fopen(file, "w");
+        if (!trace_file)
+        {
+            fprintf(stderr, "[ERROR]: Could not create trace file '%s'.\n", file);
+            exit(1);
+        }
+        fprintf(trace_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    }
+
+    // Spans go to the file whenever there is one, and to the text trace from the info level on
+    trace_spans = (trace_file || level >= TRACE_INFO) ? categories : 0;
+    if (trace_spans)
+        atexit(finish_tracing);
+}
+
+// Function to write a message to the text trace
+void trace_message(int category, const char *format, ...)
+{
+    va_list args;
+    fprintf(stderr, "[trace %s] ", trace_category_name(category));
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// Function to stop writing to the trace file in a forked process; the file and its buffered events belong to the parent
+void detach_tracing()
+{
+    trace_file = NULL;
+    trace_spans = 0;
+    trace_level = TRACE_OFF;
+}
+
+// Function to start a span
+void trace_begin(int category, int level, const char *name)
+{
+    if (trace_depth >= TRACE_MAX_DEPTH)
+    {
+        trace_depth++; // Too deep to record, but trace_end() still has to match it
+        return;
+    }
+
+    TraceSpan *span = &trace_stack[trace_depth++];
+    span->recorded = (trace_spans & category) != 0;
+    if (!span->recorded)
+        return;
+    snprintf(span->name, sizeof(span->name), "%s", name);
+    span->category = category;
+    span->level = level;
+    span->start = trace_clock();
+}
+
+// Function to end the innermost span and record it
+void trace_end()
+{
+    if (trace_depth == 0)
+        return;
+    if (trace_depth-- > TRACE_MAX_DEPTH)
+        return;
+
+    TraceSpan *span = &trace_stack[trace_depth];
+    if (!span->recorded)
+        return;
+
+    long long end = trace_clock();
+    if (TRACING(span->category, span->level))
+        trace_message(span->category, "%s: %.3f ms", span->name, (end - span->start) / 1e6);
+
+    if (trace_file)
+    {
+        fprintf(trace_file, "%s\n{\"name\": ", trace_file_events++ ? "," : "");
+        write_json_string(trace_file, span->name);
+        fprintf(trace_file, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1}",
+                trace_category_name(span->category), (span->start - trace_epoch) / 1e3, (end - span->start) / 1e3);
+    }
+}
+
+// Function to switch the span of the top-level statement being executed
+void trace_statement(int token)
+{
+    if (trace_statement_open)
+    {
+        trace_end();
+        trace_statement_open = 0;
+    }
+    if (token < 0)
+        return;
+
+    char text[64], name[96];
+    describe_statement(token, text, sizeof(text));
+    snprintf(name, sizeof(name), "line %d: %s", token_list[token].line, text);
+    trace_begin(TRACE_EXEC, TRACE_DEBUG, name);
+    trace_statement_open = 1;
+}
@@ -0,0 +1,54 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+// Categories of trace messages and spans
+#define TRACE_LEX 1
+#define TRACE_PARSE 2
+#define TRACE_EXEC 4
+#define TRACE_IO 8
+#define TRACE_ALL (TRACE_LEX | TRACE_PARSE | TRACE_EXEC | TRACE_IO)
+
+// Levels of detail of the text trace on stderr
+#define TRACE_OFF 0     // Nothing (the default)
+#define TRACE_INFO 1    // Phases and their times
+#define TRACE_DEBUG 2   // Source lines, the token list, top-level statements and output flushes
+#define TRACE_VERBOSE 3 // Every token
+
+// Level of the text trace and the categories that are traced
+extern int trace_level;
+extern int trace_categories;
+
+// Categories for which spans are recorded (in the text trace or the trace file); 0 when tracing is off, so
+// checking it is all tracing costs
+extern int trace_spans;
+
+// Returns whether messages of a category and level go to the text trace
+#define TRACING(category, level) (trace_level >= (level) && (trace_categories & (category)))
+
+// Parses a level name (off, info, debug, verbose). Returns -1 if it is not one.
+int trace_level_value(const char *name);
+
+// Parses a comma-separated list of category names (lex, parse, exec, io, all). Returns 0 if a name is not one.
+int trace_category_mask(const char *list);
+
+// Sets up tracing; file receives Chrome trace events (open with chrome://tracing or Perfetto), NULL for none
+void start_tracing(int level, int categories, const char *file);
+
+// Stops tracing in a forked process, leaving the trace file to the parent
+void detach_tracing();
+
+// Writes a message to the text trace
+void trace_message(int category, const char *format, ...);
+
+// Starts a span of a category. Spans nest; the text trace shows them at the given level once they end.
+void trace_begin(int category, int level, const char *name);
+
+// Ends the innermost span
+void trace_end();
+
+// Ends the span of the previous top-level statement, if any, and starts one for the statement at the given token
+// (none if it is -1)
+void trace_statement(int token);
+
+#endif
@@ -0,0 +1,97 @@
+#!/bin/sh
+# Checks of behaviour that only shows while the interpreter runs: timers that fire during compiled loops and the
+# binding of program variables from the command line.
+# Usage: tests/run_checks.sh [PPP], where PPP is the interpreter binary (default: ./ppp). Exits with 1 if a check fails.
+
+PPP=${1:-./ppp}
+case "$PPP" in
+/*) ;;
+*) PPP="$(pwd)/$PPP" ;;
+esac
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK" || exit 1
+
+failures=0
+
+pass()
+{
+    echo "ok   $1"
+}
+
+fail()
+{
+    echo "FAIL $1"
+    failures=$((failures + 1))
+}
+
+# A nested loop that runs far longer than any check waits for. After 16 iterations its body, inner loop included,
+# runs as compiled code.
+cat > hot.ppp <<'EOF'
+number a; number b; number c;
+a := 0; b := 0; c := 0;
+repeat 1000000 times {
+  repeat 10000 times { a += 3; b += a; b -= 1; c := a; c %= 7; }
+}
+write a and newline;
+EOF
+
+# Function to start the hot loop with the given options, wait a few seconds and stop it again
+run_hot_loop()
+{
+    "$PPP" "$@" hot < /dev/null > hot.out 2>&1 &
+    pid=$!
+    sleep 4
+    kill "$pid" 2> /dev/null
+    wait "$pid" 2> /dev/null
+}
+
+# --checkpoint-every writes a snapshot while a compiled loop runs
+run_hot_loop --checkpoint-every 1 hot.ckpt
+if [ -s hot.ckpt ]; then
+    pass "checkpoint written during a compiled loop"
+else
+    fail "checkpoint written during a compiled loop"
+fi
+
+# --metrics-interval writes the metrics file while a compiled loop runs, not only when the run ends
+run_hot_loop --metrics hot.json --metrics-interval 1
+if [ -s hot.json ]; then
+    pass "metrics written during a compiled loop"
+else
+    fail "metrics written during a compiled loop"
+fi
+
+# A --param name or a --params column the program never declares is an error, not silently ignored
+cat > sized.ppp <<'EOF'
+number iters;
+iters := 10;
+write iters and newline;
+EOF
+printf 'itres\n20\n' > sized.csv
+if "$PPP" --param itres=20 sized > sized.out 2>&1; then
+    fail "--param of an undeclared variable rejected"
+elif grep -q "itres" sized.out; then
+    pass "--param of an undeclared variable rejected"
+else
+    fail "--param of an undeclared variable rejected"
+fi
+if "$PPP" --params sized.csv sized > sized.out 2>&1; then
+    fail "--params column of an undeclared variable rejected"
+elif grep -q "itres" sized.out; then
+    pass "--params column of an undeclared variable rejected"
+else
+    fail "--params column of an undeclared variable rejected"
+fi
+if "$PPP" --param iters=20 sized > sized.out 2>&1 && grep -q "^20$" sized.out; then
+    pass "--param of a declared variable accepted"
+else
+    fail "--param of a declared variable accepted"
+fi
+
+if [ "$failures" -gt 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "All checks passed"